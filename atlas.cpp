@@ -0,0 +1,206 @@
+#include "atlas.h"
+#include "textures.h"
+#include "errormsg.h"
+#include "nlohmann/json.hpp"
+#include <execution>
+#include <fstream>
+
+using namespace rx3utils;
+using namespace DirectX;
+
+struct AtlasThumbnail {
+    string name;
+    size_t chunk = 0;
+    uint32_t sourceWidth = 0;
+    uint32_t sourceHeight = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t page = 0;
+    uint32_t x = 0;
+    uint32_t y = 0;
+    string skipReason;
+};
+
+struct AtlasFile {
+    path filePath;
+    string name;
+    vector<AtlasThumbnail> thumbs;
+    string skipReason;
+};
+
+// thumbnail sizes come from the texture headers alone, so the whole layout is known before anything is decoded
+static void ReadThumbnailSizes(AtlasFile &file, uint32_t thumbnailSize) {
+    Rx3File raw;
+    if (!raw.Open(file.filePath)) {
+        file.skipReason = "unable to read file";
+        return;
+    }
+    auto textures = raw.FindChunks(RX3_CHUNK_TEXTURE);
+    for (size_t i = 0; i < textures.size(); i++) {
+        AtlasThumbnail &thumb = file.thumbs.emplace_back();
+        thumb.name = textures[i]->name;
+        thumb.chunk = i;
+        Rx3TextureInfo info;
+        if (!ReadRx3TextureInfo(raw, *textures[i], info)) {
+            thumb.skipReason = "invalid texture header";
+            continue;
+        }
+        thumb.sourceWidth = info.width;
+        thumb.sourceHeight = info.height;
+        if (raw.IsBigEndian()) {
+            thumb.skipReason = "big-endian texture";
+            continue;
+        }
+        if (!CanDecodeRx3Texture(raw, *textures[i])) {
+            thumb.skipReason = "unsupported format " + Rx3TextureFormatName(info.format);
+            continue;
+        }
+        uint32_t level = SelectRx3TextureLevel(info, thumbnailSize);
+        thumb.width = max<uint32_t>(info.width >> level, 1);
+        thumb.height = max<uint32_t>(info.height >> level, 1);
+        if (thumb.width > thumbnailSize || thumb.height > thumbnailSize) {
+            double scale = double(thumbnailSize) / double(max(thumb.width, thumb.height));
+            thumb.width = max<uint32_t>(uint32_t(thumb.width * scale), 1);
+            thumb.height = max<uint32_t>(uint32_t(thumb.height * scale), 1);
+        }
+    }
+}
+
+static void RenderThumbnails(AtlasFile const &file, vector<AtlasThumbnail *> const &thumbs, uint32_t thumbnailSize, Image const &page) {
+    Rx3File raw;
+    if (!raw.Open(file.filePath)) {
+        for (auto *t : thumbs)
+            t->skipReason = "unable to read file";
+        return;
+    }
+    auto textures = raw.FindChunks(RX3_CHUNK_TEXTURE);
+    for (auto *t : thumbs) {
+        ScratchImage decoded;
+        if (t->chunk >= textures.size() || !DecodeRx3Texture(raw, *textures[t->chunk], thumbnailSize, decoded)) {
+            t->skipReason = "decoding failed";
+            continue;
+        }
+        ScratchImage resized;
+        Image const *src = decoded.GetImage(0, 0, 0);
+        if (src->width != t->width || src->height != t->height) {
+            // worker threads have no COM apartment, so WIC scalers are not available here
+            if (FAILED(Resize(*src, t->width, t->height, TEX_FILTER_BOX | TEX_FILTER_FORCE_NON_WIC, resized))) {
+                t->skipReason = "resizing failed";
+                continue;
+            }
+            src = resized.GetImage(0, 0, 0);
+        }
+        // thumbnails never overlap, so files on the same page can be copied concurrently
+        CopyRectangle(*src, Rect(0, 0, src->width, src->height), page, TEX_FILTER_DEFAULT, t->x, t->y);
+    }
+}
+
+bool GenerateTextureAtlas(vector<path> const &rx3Files, path const &inputFolder, path const &outFolder,
+    uint32_t thumbnailSize, uint32_t pageSize)
+{
+    if (thumbnailSize == 0 || pageSize < thumbnailSize)
+        return false;
+    vector<AtlasFile> files(rx3Files.size());
+    for (size_t i = 0; i < files.size(); i++) {
+        files[i].filePath = rx3Files[i];
+        path rel = inputFolder.empty() ? rx3Files[i].filename() : relative(rx3Files[i], inputFolder);
+        files[i].name = ToUTF8(rel.generic_wstring());
+    }
+    std::for_each(std::execution::par, files.begin(), files.end(), [&](AtlasFile &f) {
+        ReadThumbnailSizes(f, thumbnailSize);
+    });
+    vector<AtlasThumbnail *> thumbs;
+    for (auto &f : files) {
+        for (auto &t : f.thumbs) {
+            if (t.skipReason.empty())
+                thumbs.push_back(&t);
+        }
+    }
+    // shelf packing, tallest first
+    std::stable_sort(thumbs.begin(), thumbs.end(), [](AtlasThumbnail const *a, AtlasThumbnail const *b) {
+        return a->height > b->height;
+    });
+    uint32_t page = 0, x = 0, y = 0, shelfHeight = 0;
+    for (auto *t : thumbs) {
+        if (x + t->width > pageSize) {
+            x = 0;
+            y += shelfHeight;
+            shelfHeight = 0;
+        }
+        if (y + t->height > pageSize) {
+            page++;
+            x = 0;
+            y = 0;
+            shelfHeight = 0;
+        }
+        t->page = page;
+        t->x = x;
+        t->y = y;
+        x += t->width;
+        shelfHeight = max(shelfHeight, t->height);
+    }
+    uint32_t numPages = thumbs.empty() ? 0 : (page + 1);
+    // per page, the thumbnails of each file that land on it
+    vector<vector<pair<AtlasFile const *, vector<AtlasThumbnail *>>>> pages(numPages);
+    for (auto &f : files) {
+        for (auto &t : f.thumbs) {
+            if (!t.skipReason.empty())
+                continue;
+            auto &pageFiles = pages[t.page];
+            if (pageFiles.empty() || pageFiles.back().first != &f)
+                pageFiles.emplace_back(&f, vector<AtlasThumbnail *>());
+            pageFiles.back().second.push_back(&t);
+        }
+    }
+    create_directories(outFolder);
+    nlohmann::json index;
+    index["thumbnailSize"] = thumbnailSize;
+    index["pageSize"] = pageSize;
+    index["pages"] = nlohmann::json::array();
+    // only one page is held in memory at a time, thumbnails are decoded when their page is rendered
+    for (uint32_t p = 0; p < numPages; p++) {
+        ScratchImage pageImage;
+        if (FAILED(pageImage.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, pageSize, pageSize, 1, 1)))
+            return false;
+        memset(pageImage.GetPixels(), 0, pageImage.GetPixelsSize());
+        Image const &pageTarget = *pageImage.GetImage(0, 0, 0);
+        std::for_each(std::execution::par, pages[p].begin(), pages[p].end(), [&](auto const &pageFile) {
+            RenderThumbnails(*pageFile.first, pageFile.second, thumbnailSize, pageTarget);
+        });
+        char pageName[32];
+        sprintf(pageName, "atlas_%03u.png", p);
+        if (!SaveTextureImage(pageTarget, outFolder / pageName))
+            return false;
+        index["pages"].push_back(pageName);
+    }
+    auto &textures = index["textures"] = nlohmann::json::array();
+    auto &skipped = index["skipped"] = nlohmann::json::array();
+    for (auto const &f : files) {
+        if (!f.skipReason.empty())
+            skipped.push_back({ { "rx3", f.name }, { "reason", f.skipReason } });
+        for (auto const &t : f.thumbs) {
+            if (!t.skipReason.empty()) {
+                skipped.push_back({ { "rx3", f.name }, { "name", t.name }, { "reason", t.skipReason } });
+                continue;
+            }
+            textures.push_back({
+                { "rx3", f.name },
+                { "name", t.name },
+                { "page", t.page },
+                { "x", t.x },
+                { "y", t.y },
+                { "width", t.width },
+                { "height", t.height },
+                { "sourceWidth", t.sourceWidth },
+                { "sourceHeight", t.sourceHeight }
+            });
+        }
+    }
+    std::ofstream indexFile(outFolder / L"atlas.json");
+    if (!indexFile.is_open())
+        return false;
+    indexFile << index.dump(1, '\t');
+    if (!skipped.empty())
+        ErrorMessage(std::to_string(skipped.size()) + " texture(s) or file(s) were not added to the atlas, see \"skipped\" in atlas.json");
+    return true;
+}
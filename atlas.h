@@ -0,0 +1,8 @@
+#pragma once
+#include "Rx3Utils.h"
+#include <cstdint>
+
+// Packs a low mip of every texture from the given rx3 files into square atlas pages (atlas_NNN.png)
+// and writes atlas.json mapping each rx3 file and texture name to its page and rectangle
+bool GenerateTextureAtlas(vector<path> const &rx3Files, path const &inputFolder, path const &outFolder,
+    uint32_t thumbnailSize, uint32_t pageSize);
@@ -0,0 +1,104 @@
+#include "buildcache.h"
+#include "mappedfile.h"
+#include "hash.h"
+#include <Windows.h>
+#include <atomic>
+
+using namespace rx3utils;
+
+static void HashString(Hasher64 &hasher, wstring const &str) {
+    hasher.UpdateValue(uint64_t(str.size()));
+    hasher.Update(str.data(), str.size() * sizeof(wchar_t));
+}
+
+static void HashFileContents(Hasher64 &hasher, path const &filePath) {
+    MappedFile file;
+    if (file.Open(filePath)) {
+        hasher.UpdateValue(uint64_t(file.Size()));
+        hasher.UpdateValue(Hash64(file.Data(), file.Size()));
+    }
+    else
+        hasher.UpdateValue(uint64_t(0));
+}
+
+static wstring KeyName(uint64_t key) {
+    wchar_t name[17];
+    swprintf(name, 17, L"%016llx", (unsigned long long)key);
+    return name;
+}
+
+static bool CopyTree(path const &from, path const &to) {
+    std::error_code ec;
+    create_directories(to, ec);
+    copy(from, to, copy_options::recursive | copy_options::overwrite_existing, ec);
+    return !ec;
+}
+
+uint64_t BuildKey(string const &version) {
+    Hasher64 hasher;
+    HashString(hasher, AtoW(version));
+    wchar_t exePath[MAX_PATH];
+    DWORD exePathLength = GetModuleFileNameW(nullptr, exePath, MAX_PATH);
+    if (exePathLength != 0 && exePathLength < MAX_PATH)
+        HashFileContents(hasher, exePath);
+    return hasher.Digest();
+}
+
+BuildCache::BuildCache(path const &folder, string const &version, CommandLine const &cmd, set<wstring> const &ignored) : mFolder(folder) {
+    if (mFolder.empty())
+        return;
+    std::error_code ec;
+    create_directories(mFolder, ec);
+    Hasher64 hasher;
+    hasher.UpdateValue(BuildKey(version));
+    for (auto const &option : cmd.Options()) {
+        if (!ignored.contains(option))
+            HashString(hasher, option);
+    }
+    for (auto const &[argument, values] : cmd.Arguments()) {
+        if (ignored.contains(argument))
+            continue;
+        HashString(hasher, argument);
+        for (auto const &value : values) {
+            if (is_regular_file(path(value), ec))
+                HashFileContents(hasher, value);
+            else
+                HashString(hasher, value);
+        }
+    }
+    mSettingsKey = hasher.Digest();
+}
+
+uint64_t BuildCache::JobKey(string const &kind, wstring const &name, vector<path> const &inputs) const {
+    Hasher64 hasher(mSettingsKey);
+    HashString(hasher, AtoW(kind));
+    HashString(hasher, name);
+    for (auto const &input : inputs) {
+        HashString(hasher, input.filename().wstring());
+        HashFileContents(hasher, input);
+    }
+    return hasher.Digest();
+}
+
+bool BuildCache::Restore(uint64_t key, path const &outFolder) const {
+    path entry = mFolder / KeyName(key);
+    std::error_code ec;
+    return is_directory(entry, ec) && CopyTree(entry, outFolder);
+}
+
+void BuildCache::Store(uint64_t key, path const &resultFolder) const {
+    path entry = mFolder / KeyName(key);
+    std::error_code ec;
+    if (exists(entry, ec))
+        return;
+    // unique per process and call, parallel jobs can store the same key
+    static std::atomic<uint32_t> counter = 0;
+    path staging = mFolder / (KeyName(key) + L".tmp" + to_wstring(GetCurrentProcessId()) + L"_" + to_wstring(counter++));
+    if (CopyTree(resultFolder, staging)) {
+        rename(staging, entry, ec);
+        if (!ec)
+            return;
+    }
+    // another job published the same key first
+    remove_all(staging, ec);
+}
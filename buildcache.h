@@ -0,0 +1,24 @@
+#pragma once
+#include "Rx3Utils.h"
+#include "commandline.h"
+#include <cstdint>
+
+// Content-addressed cache of import/export results (-cache <dir>), safe to share between machines.
+// An entry is a folder named after the job key holding the job's output tree; entries are published by
+// renaming a fully written folder, so readers never see partial results.
+// rx3c version and executable contents; rx3lib, DirectXTex and ModelLibrary are linked in, so this identifies the build
+uint64_t BuildKey(string const &version);
+
+class BuildCache {
+    path mFolder;
+    uint64_t mSettingsKey = 0;
+public:
+    // settings key: rx3c version and executable contents plus all arguments and options except the ignored
+    // ones; arguments naming existing files (texFormatFile, skeleton, baseModel, ...) contribute the file contents
+    BuildCache(path const &folder, string const &version, CommandLine const &cmd, set<wstring> const &ignored);
+    bool IsEnabled() const { return !mFolder.empty(); }
+    // job key: settings key, job kind and name, then contents of every input file
+    uint64_t JobKey(string const &kind, wstring const &name, vector<path> const &inputs) const;
+    bool Restore(uint64_t key, path const &outFolder) const;
+    void Store(uint64_t key, path const &resultFolder) const;
+};
@@ -0,0 +1,116 @@
+#include "byteswap.h"
+#include <bit>
+#include <numeric>
+#include <cstring>
+#include <intrin.h>
+#include <emmintrin.h>
+#include <tmmintrin.h>
+
+static bool HasSSSE3() {
+    static bool const result = [] {
+        int info[4] = {};
+        __cpuid(info, 1);
+        return (info[2] & (1 << 9)) != 0;
+    }();
+    return result;
+}
+
+void SwapBytes16(void *data, size_t count) {
+    auto p = static_cast<uint8_t *>(data);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8, p += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i *>(p));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+    }
+    for (; i < count; i++, p += 2) {
+        uint16_t w;
+        memcpy(&w, p, 2);
+        w = std::byteswap(w);
+        memcpy(p, &w, 2);
+    }
+}
+
+void SwapBytes32(void *data, size_t count) {
+    auto p = static_cast<uint8_t *>(data);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, p += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i *>(p));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+    }
+    for (; i < count; i++, p += 4) {
+        uint32_t w;
+        memcpy(&w, p, 4);
+        w = std::byteswap(w);
+        memcpy(p, &w, 4);
+    }
+}
+
+static void SwapRecordScalar(uint8_t *record, SwapLayout const &layout) {
+    for (auto const &[offset, size] : layout.words) {
+        if (size == 2)
+            std::swap(record[offset], record[offset + 1]);
+        else if (size == 4) {
+            std::swap(record[offset], record[offset + 3]);
+            std::swap(record[offset + 1], record[offset + 2]);
+        }
+    }
+}
+
+void SwapBytesStrided(void *data, size_t count, SwapLayout const &layout) {
+    if (layout.stride == 0 || layout.words.empty() || count == 0)
+        return;
+    auto p = static_cast<uint8_t *>(data);
+    // records made only of same-sized words that tile the whole stride are a flat swap
+    uint32_t covered = 0;
+    bool all16 = true, all32 = true, aligned = true;
+    for (auto const &[offset, size] : layout.words) {
+        covered += size;
+        all16 = all16 && size == 2;
+        all32 = all32 && size == 4;
+        aligned = aligned && (size == 2 || size == 4) && (offset % size) == 0 && offset + size <= layout.stride;
+    }
+    if (covered == layout.stride && aligned) {
+        if (all32) {
+            SwapBytes32(p, count * layout.stride / 4);
+            return;
+        }
+        if (all16) {
+            SwapBytes16(p, count * layout.stride / 2);
+            return;
+        }
+    }
+    // mixed layouts: the word pattern repeats every lcm(stride, 16) bytes, so one shuffle mask per 16-byte block
+    size_t period = std::lcm(size_t(layout.stride), size_t(16));
+    if (!aligned || (layout.stride % 4) != 0 || period > 1024 || !HasSSSE3()) {
+        for (size_t i = 0; i < count; i++)
+            SwapRecordScalar(p + i * layout.stride, layout);
+        return;
+    }
+    std::vector<uint8_t> perm(period);
+    for (size_t b = 0; b < period; b++)
+        perm[b] = uint8_t(b % 16);
+    for (size_t r = 0; r < period; r += layout.stride) {
+        for (auto const &[offset, size] : layout.words) {
+            for (uint32_t b = 0; b < size; b++)
+                perm[r + offset + b] = uint8_t((r + offset + size - 1 - b) % 16);
+        }
+    }
+    std::vector<__m128i> masks(period / 16);
+    for (size_t m = 0; m < masks.size(); m++)
+        masks[m] = _mm_loadu_si128(reinterpret_cast<__m128i const *>(&perm[m * 16]));
+    size_t totalBytes = count * layout.stride;
+    size_t numPeriods = totalBytes / period;
+    for (size_t i = 0; i < numPeriods; i++, p += period) {
+        for (size_t m = 0; m < masks.size(); m++) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i *>(p + m * 16));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(p + m * 16), _mm_shuffle_epi8(v, masks[m]));
+        }
+    }
+    size_t remaining = (totalBytes - numPeriods * period) / layout.stride;
+    for (size_t i = 0; i < remaining; i++)
+        SwapRecordScalar(p + i * layout.stride, layout);
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <utility>
+
+// Interleaved record layout for strided swaps (vertex buffers): words are (offset, size) pairs, size is 2 or 4
+struct SwapLayout {
+    uint32_t stride = 0;
+    std::vector<std::pair<uint32_t, uint32_t>> words;
+};
+
+void SwapBytes16(void *data, size_t count);
+void SwapBytes32(void *data, size_t count);
+void SwapBytesStrided(void *data, size_t count, SwapLayout const &layout);
@@ -0,0 +1,257 @@
+#include "catalog.h"
+#include "rx3file.h"
+#include "textures.h"
+#include "hash.h"
+#include <fstream>
+#include <execution>
+#include "nlohmann/json.hpp"
+
+using namespace rx3utils;
+
+static char const RX3_CATALOG_MAGIC[8] = { 'R', 'X', '3', 'C', 'A', 'T', '0', '1' };
+
+bool Rx3Catalog::Open(path const &catalogPath) {
+    Close();
+    if (!mMapped.Open(catalogPath) || mMapped.Size() < sizeof(Rx3CatalogHeader))
+        return false;
+    auto header = reinterpret_cast<Rx3CatalogHeader const *>(mMapped.Data());
+    size_t size = sizeof(Rx3CatalogHeader) + size_t(header->numFiles) * sizeof(Rx3CatalogFile) +
+        size_t(header->numChunks) * sizeof(Rx3CatalogChunk) + size_t(header->numTextures) * sizeof(Rx3CatalogTexture) +
+        header->stringsSize;
+    if (memcmp(header->magic, RX3_CATALOG_MAGIC, 8) != 0 || size != mMapped.Size()) {
+        mMapped.Close();
+        return false;
+    }
+    mHeader = header;
+    mFiles = reinterpret_cast<Rx3CatalogFile const *>(header + 1);
+    mChunks = reinterpret_cast<Rx3CatalogChunk const *>(mFiles + header->numFiles);
+    mTextures = reinterpret_cast<Rx3CatalogTexture const *>(mChunks + header->numChunks);
+    mStrings = reinterpret_cast<char const *>(mTextures + header->numTextures);
+    return true;
+}
+
+void Rx3Catalog::Close() {
+    mMapped.Close();
+    mHeader = nullptr;
+    mFiles = nullptr;
+    mChunks = nullptr;
+    mTextures = nullptr;
+    mStrings = nullptr;
+}
+
+namespace {
+
+struct CatalogEntry {
+    string path;
+    Rx3CatalogFile file = {};
+    vector<Rx3CatalogChunk> chunks;
+    vector<string> chunkNames;
+    vector<Rx3CatalogTexture> textures;
+    vector<string> textureNames;
+};
+
+class StringPool {
+    vector<char> mData;
+    map<string, Rx3CatalogString, std::less<>> mStrings;
+public:
+    Rx3CatalogString Add(std::string_view s) {
+        auto it = mStrings.find(s);
+        if (it != mStrings.end())
+            return it->second;
+        Rx3CatalogString result = { uint32_t(mData.size()), uint32_t(s.size()) };
+        mData.insert(mData.end(), s.begin(), s.end());
+        mStrings.emplace(string(s), result);
+        return result;
+    }
+    vector<char> const &Data() const { return mData; }
+};
+
+}
+
+static int64_t FileWriteTime(path const &p) {
+    std::error_code ec;
+    auto time = last_write_time(p, ec);
+    return ec ? 0 : int64_t(time.time_since_epoch().count());
+}
+
+static bool ReadCatalogEntry(path const &filePath, CatalogEntry &entry) {
+    Rx3File rx3;
+    if (!rx3.Open(filePath))
+        return false;
+    entry.file.flags = rx3.IsBigEndian() ? RX3_CATALOG_BIG_ENDIAN : 0;
+    for (auto const &c : rx3.Chunks()) {
+        Rx3CatalogChunk chunk = {};
+        chunk.type = c.type;
+        chunk.offset = c.offset;
+        chunk.size = c.size;
+        chunk.hash = Hash64(rx3.ChunkData(c), c.size);
+        entry.chunks.push_back(chunk);
+        entry.chunkNames.push_back(c.name);
+        if (c.type == RX3_CHUNK_TEXTURE) {
+            Rx3TextureInfo info;
+            if (ReadRx3TextureInfo(rx3, c, info)) {
+                Rx3CatalogTexture texture = {};
+                texture.width = info.width;
+                texture.height = info.height;
+                texture.depth = info.depth;
+                texture.faces = uint16_t(info.NumFaces());
+                texture.format = info.format;
+                texture.levels = info.levels;
+                entry.textures.push_back(texture);
+                entry.textureNames.push_back(c.name);
+            }
+        }
+        else if (c.type == RX3_CHUNK_VERTEX_BUFFER && c.size >= 16) {
+            entry.file.numMeshes++;
+            entry.file.numVertices += rx3.Read32(rx3.ChunkData(c) + 4);
+        }
+        else if (c.type == RX3_CHUNK_INDEX_BUFFER && c.size >= 16)
+            entry.file.numIndices += rx3.Read32(rx3.ChunkData(c) + 4);
+        else if (c.type == RX3_CHUNK_SKELETON)
+            entry.file.flags |= RX3_CATALOG_SKELETON;
+        else if (c.type == RX3_CHUNK_MORPH)
+            entry.file.flags |= RX3_CATALOG_MORPHS;
+        else if (c.type == RX3_CHUNK_HOTSPOT)
+            entry.file.flags |= RX3_CATALOG_HOTSPOT;
+    }
+    return true;
+}
+
+static void CopyCatalogEntry(Rx3Catalog const &catalog, Rx3CatalogFile const &file, CatalogEntry &entry) {
+    entry.file = file;
+    entry.chunks.assign(catalog.Chunks(file), catalog.Chunks(file) + file.numChunks);
+    for (auto const &c : entry.chunks)
+        entry.chunkNames.emplace_back(catalog.String(c.name));
+    entry.textures.assign(catalog.Textures(file), catalog.Textures(file) + file.numTextures);
+    for (auto const &t : entry.textures)
+        entry.textureNames.emplace_back(catalog.String(t.name));
+}
+
+bool UpdateRx3Catalog(path const &catalogPath, path const &root, vector<path> const &rx3Files, vector<path> &failedFiles) {
+    vector<path> catalogFiles = rx3Files;
+    vector<CatalogEntry> entries;
+    vector<size_t> changed;
+    {
+        Rx3Catalog previous;
+        map<std::string_view, Rx3CatalogFile const *> previousFiles;
+        if (previous.Open(catalogPath)) {
+            for (uint32_t i = 0; i < previous.NumFiles(); i++)
+                previousFiles[previous.String(previous.File(i).path)] = &previous.File(i);
+        }
+        set<string> listed;
+        for (auto const &f : rx3Files)
+            listed.insert(ToUTF8(relative(f, root).generic_wstring()));
+        // files cataloged before and not given now are kept (and refreshed) while they exist, so a run over
+        // part of the tree merges into the catalog instead of replacing it
+        for (auto const &[name, file] : previousFiles) {
+            path filePath = root / path(std::u8string(name.begin(), name.end()));
+            std::error_code ec;
+            if (!listed.contains(string(name)) && is_regular_file(filePath, ec))
+                catalogFiles.push_back(filePath);
+        }
+        entries.resize(catalogFiles.size());
+        for (size_t i = 0; i < catalogFiles.size(); i++) {
+            auto &entry = entries[i];
+            entry.path = ToUTF8(relative(catalogFiles[i], root).generic_wstring());
+            std::error_code ec;
+            uint64_t fileSize = file_size(catalogFiles[i], ec);
+            int64_t writeTime = FileWriteTime(catalogFiles[i]);
+            auto it = previousFiles.find(entry.path);
+            if (it != previousFiles.end() && it->second->fileSize == fileSize && it->second->writeTime == writeTime)
+                CopyCatalogEntry(previous, *it->second, entry);
+            else {
+                entry.file.fileSize = fileSize;
+                entry.file.writeTime = writeTime;
+                changed.push_back(i);
+            }
+        }
+    }
+    vector<uint8_t> valid(catalogFiles.size(), 1);
+    std::for_each(std::execution::par, changed.begin(), changed.end(), [&](size_t i) {
+        valid[i] = ReadCatalogEntry(catalogFiles[i], entries[i]);
+    });
+    for (size_t i = 0; i < catalogFiles.size(); i++) {
+        if (!valid[i])
+            failedFiles.push_back(catalogFiles[i]);
+    }
+
+    StringPool strings;
+    vector<Rx3CatalogFile> files;
+    vector<Rx3CatalogChunk> chunks;
+    vector<Rx3CatalogTexture> textures;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (!valid[i])
+            continue;
+        auto &entry = entries[i];
+        entry.file.path = strings.Add(entry.path);
+        entry.file.firstChunk = uint32_t(chunks.size());
+        entry.file.numChunks = uint32_t(entry.chunks.size());
+        entry.file.firstTexture = uint32_t(textures.size());
+        entry.file.numTextures = uint32_t(entry.textures.size());
+        for (size_t c = 0; c < entry.chunks.size(); c++) {
+            entry.chunks[c].name = strings.Add(entry.chunkNames[c]);
+            chunks.push_back(entry.chunks[c]);
+        }
+        for (size_t t = 0; t < entry.textures.size(); t++) {
+            entry.textures[t].name = strings.Add(entry.textureNames[t]);
+            textures.push_back(entry.textures[t]);
+        }
+        files.push_back(entry.file);
+    }
+    Rx3CatalogHeader header = {};
+    memcpy(header.magic, RX3_CATALOG_MAGIC, 8);
+    header.numFiles = uint32_t(files.size());
+    header.numChunks = uint32_t(chunks.size());
+    header.numTextures = uint32_t(textures.size());
+    header.stringsSize = uint32_t(strings.Data().size());
+    // written next to the old catalog and renamed over it, so readers never see a partial file
+    path tempPath = catalogPath;
+    tempPath += L".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary);
+        if (!file)
+            return false;
+        file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+        file.write(reinterpret_cast<char const *>(files.data()), files.size() * sizeof(Rx3CatalogFile));
+        file.write(reinterpret_cast<char const *>(chunks.data()), chunks.size() * sizeof(Rx3CatalogChunk));
+        file.write(reinterpret_cast<char const *>(textures.data()), textures.size() * sizeof(Rx3CatalogTexture));
+        file.write(strings.Data().data(), strings.Data().size());
+        if (!file.good())
+            return false;
+    }
+    std::error_code ec;
+    rename(tempPath, catalogPath, ec);
+    return !ec;
+}
+
+vector<string> QueryRx3Catalog(Rx3Catalog const &catalog, Rx3CatalogQuery const &query) {
+    vector<string> lines;
+    bool textureQuery = !query.textureNames.empty() || !query.formats.empty() || query.minTextureSize != 0;
+    set<string> formats;
+    for (auto const &f : query.formats)
+        formats.insert(NormalizeTextureFormatName(f));
+    for (uint32_t i = 0; i < catalog.NumFiles(); i++) {
+        auto const &file = catalog.File(i);
+        nlohmann::ordered_json result;
+        result["file"] = catalog.String(file.path);
+        if (textureQuery) {
+            auto textures = nlohmann::ordered_json::array();
+            for (uint32_t t = 0; t < file.numTextures; t++) {
+                auto const &texture = catalog.Textures(file)[t];
+                string name(catalog.String(texture.name));
+                if ((!query.textureNames.empty() && FindTexturePattern(ToLower(name), query.textureNames).empty()) ||
+                    (!formats.empty() && !formats.contains(Rx3TextureFormatName(texture.format))) ||
+                    max(texture.width, texture.height) < query.minTextureSize)
+                {
+                    continue;
+                }
+                textures.push_back(name);
+            }
+            if (textures.empty())
+                continue;
+            result["textures"] = textures;
+        }
+        lines.push_back(result.dump());
+    }
+    return lines;
+}
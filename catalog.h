@@ -0,0 +1,94 @@
+#pragma once
+#include "mappedfile.h"
+#include <cstdint>
+#include <string_view>
+
+// On-disk index of an asset tree: per rx3 file its chunks (type, name, offset, size, hash), texture properties
+// and mesh stats. The file is a header followed by fixed-size record arrays and one string pool, so it is
+// used directly from a read-only mapping.
+struct Rx3CatalogHeader {
+    char magic[8];
+    uint32_t numFiles;
+    uint32_t numChunks;
+    uint32_t numTextures;
+    uint32_t stringsSize;
+};
+
+struct Rx3CatalogString {
+    uint32_t offset;
+    uint32_t length;
+};
+
+enum Rx3CatalogFileFlags : uint32_t {
+    RX3_CATALOG_BIG_ENDIAN = 1,
+    RX3_CATALOG_SKELETON = 2,
+    RX3_CATALOG_MORPHS = 4,
+    RX3_CATALOG_HOTSPOT = 8
+};
+
+struct Rx3CatalogFile {
+    Rx3CatalogString path; // relative to the catalog root, '/' separated
+    uint64_t fileSize;
+    int64_t writeTime;
+    uint32_t firstChunk;
+    uint32_t numChunks;
+    uint32_t firstTexture;
+    uint32_t numTextures;
+    uint32_t flags;
+    uint32_t numMeshes;
+    uint64_t numVertices;
+    uint64_t numIndices;
+};
+
+struct Rx3CatalogChunk {
+    uint32_t type;
+    uint32_t offset;
+    uint32_t size;
+    Rx3CatalogString name;
+    uint32_t padding;
+    uint64_t hash;
+};
+
+struct Rx3CatalogTexture {
+    Rx3CatalogString name;
+    uint16_t width;
+    uint16_t height;
+    uint16_t depth;
+    uint16_t faces;
+    uint8_t format;
+    uint8_t levels;
+    uint16_t padding;
+};
+
+class Rx3Catalog {
+    MappedFile mMapped;
+    Rx3CatalogHeader const *mHeader = nullptr;
+    Rx3CatalogFile const *mFiles = nullptr;
+    Rx3CatalogChunk const *mChunks = nullptr;
+    Rx3CatalogTexture const *mTextures = nullptr;
+    char const *mStrings = nullptr;
+public:
+    bool Open(path const &catalogPath);
+    void Close();
+    uint32_t NumFiles() const { return mHeader ? mHeader->numFiles : 0; }
+    Rx3CatalogFile const &File(uint32_t index) const { return mFiles[index]; }
+    Rx3CatalogChunk const *Chunks(Rx3CatalogFile const &file) const { return mChunks + file.firstChunk; }
+    Rx3CatalogTexture const *Textures(Rx3CatalogFile const &file) const { return mTextures + file.firstTexture; }
+    std::string_view String(Rx3CatalogString const &s) const { return std::string_view(mStrings + s.offset, s.length); }
+};
+
+// Updates the catalog with rx3Files (all under root). Files already in the catalog stay in it while they
+// exist. Records of files whose size and write time did not change are taken from the existing catalog, the
+// others are read in parallel; files that can't be read are left out and added to failedFiles.
+bool UpdateRx3Catalog(path const &catalogPath, path const &root, vector<path> const &rx3Files, vector<path> &failedFiles);
+
+// Texture conditions apply together to each texture (names are wildcard patterns, formats as in
+// Rx3TextureFormatName or their BCn aliases, minTextureSize against the larger side); a file matches if any texture does.
+// Without texture conditions every file matches. Returns one JSON line per matching file.
+struct Rx3CatalogQuery {
+    vector<string> textureNames;
+    vector<string> formats;
+    uint32_t minTextureSize = 0;
+};
+
+vector<string> QueryRx3Catalog(Rx3Catalog const &catalog, Rx3CatalogQuery const &query);
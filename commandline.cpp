@@ -8,11 +8,18 @@ std::wstring CommandLine::ToLower(std::wstring const &str) {
     return result;
 }
 
-CommandLine::CommandLine(int argc, wchar_t *argv[], std::set<std::wstring> const &arguments, std::set<std::wstring> const &options) {
+CommandLine::CommandLine(int argc, wchar_t *argv[], std::set<std::wstring> const &arguments, std::set<std::wstring> const &options,
+    std::set<std::wstring> const &multiValueArguments)
+{
     std::set<std::wstring> _arguments;
     std::set<std::wstring> _options;
+    std::set<std::wstring> _multiValueArguments;
     for (auto const &s : arguments) _arguments.insert(ToLower(s));
     for (auto const &s : options)   _options.insert(ToLower(s));
+    for (auto const &s : multiValueArguments) {
+        _arguments.insert(ToLower(s));
+        _multiValueArguments.insert(ToLower(s));
+    }
     for (int i = 1; i < argc; i++) {
         std::wstring arg = argv[i];
         if (arg.starts_with(L'-') || arg.starts_with(L'/')) {
@@ -22,6 +29,10 @@ CommandLine::CommandLine(int argc, wchar_t *argv[], std::set<std::wstring> const
                     mArguments[arg].push_back(argv[i + 1]);
                     i++;
                 }
+                if (_multiValueArguments.contains(arg)) {
+                    for (; (i + 1) < argc && argv[i + 1][0] != L'-' && argv[i + 1][0] != L'/'; i++)
+                        mArguments[arg].push_back(argv[i + 1]);
+                }
             }
             else if (_options.contains(arg))
                 mOptions.insert(arg);
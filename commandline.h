@@ -11,7 +11,9 @@ class CommandLine {
 
 public:
     static std::wstring ToLower(std::wstring const &str);
-    CommandLine(int argc, wchar_t *argv[], std::set<std::wstring> const &arguments, std::set<std::wstring> const &options);
+    // multiValueArguments take every following value up to the next -argument or /argument
+    CommandLine(int argc, wchar_t *argv[], std::set<std::wstring> const &arguments, std::set<std::wstring> const &options,
+        std::set<std::wstring> const &multiValueArguments = {});
     bool HasOption(std::wstring const &option) const;
     bool HasArgument(std::wstring const &argument) const;
     std::wstring GetArgumentString(std::wstring const &argument, std::wstring const &defaultValue = L"") const;
@@ -20,4 +22,6 @@ public:
     float GetArgumentFloat(std::wstring const &argument, float defaultValue = 0.0f) const;
     std::vector<std::wstring> GetArgumentStrings(std::wstring const &argument) const;
     std::vector<std::filesystem::path> GetArgumentPaths(std::wstring const &argument) const;
+    std::set<std::wstring> const &Options() const { return mOptions; }
+    std::map<std::wstring, std::vector<std::wstring>> const &Arguments() const { return mArguments; }
 };
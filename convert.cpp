@@ -0,0 +1,217 @@
+#include "convert.h"
+#include "rx3file.h"
+#include "tempfolder.h"
+#include "errormsg.h"
+#include "Rx3Model.h"
+#include "Rx3Hotspot.h"
+#include "Rx3Morph.h"
+#include "Rx3Skeleton.h"
+#include <list>
+#include <optional>
+
+using namespace rx3utils;
+
+// the container builders modify the model, so each target gets its own copy
+static bool ConvertModel(Model model, path const &in, path const &out, Rx3Options const &targetOptions) {
+    Rx3Options options = targetOptions;
+    if (model.IsSkeleton()) {
+        if (options.targetSkeleton.bones.empty())
+            options.targetSkeleton = model.skeleton;
+        ModelToSkeletonContainer(model, in, out, options);
+    }
+    else if (model.HasShapeKeys()) {
+        if (options.baseModel.objects.empty()) {
+            ErrorMessage("Morph targets can't be converted without -baseModel: " + ToUTF8(in.c_str()));
+            return false;
+        }
+        ModelToMorphTargetsContainer(model, in, out, options);
+    }
+    else if (!model.objects.empty())
+        ModelToSimpleMeshContainer(model, in, out, options);
+    return exists(out);
+}
+
+// rx3lib decides the target's vertex declaration, so it's only known after the rebuild. A rebuilt model with the
+// source's byte order, vertex declarations and chunk counts is dropped and the source chunks are kept byte for byte.
+static bool SameModelLayout(Rx3File const &source, Rx3File const &rebuilt) {
+    if (source.IsBigEndian() != rebuilt.IsBigEndian())
+        return false;
+    auto sourceFormats = source.FindChunks(RX3_CHUNK_VERTEX_FORMAT);
+    auto rebuiltFormats = rebuilt.FindChunks(RX3_CHUNK_VERTEX_FORMAT);
+    if (sourceFormats.size() != rebuiltFormats.size())
+        return false;
+    for (size_t i = 0; i < sourceFormats.size(); i++) {
+        if (sourceFormats[i]->size != rebuiltFormats[i]->size ||
+            memcmp(source.ChunkData(*sourceFormats[i]), rebuilt.ChunkData(*rebuiltFormats[i]), sourceFormats[i]->size) != 0)
+        {
+            return false;
+        }
+    }
+    map<uint32_t, size_t> counts;
+    for (auto const &c : rebuilt.Chunks()) {
+        if (c.type != RX3_CHUNK_NAMES)
+            counts[c.type]++;
+    }
+    for (auto const &[type, count] : counts) {
+        if (source.FindChunks(type).size() != count)
+            return false;
+    }
+    return true;
+}
+
+// Textures are only rebuilt when the byte order changes, and console textures are tiled as well as
+// byte-swapped; rx3lib is the only code that (un)tiles them and it works on DDS files. The stored levels
+// go through DDS unchanged (same format, no re-encode), and the export is done once per source file.
+struct ExtractedTextures {
+    vector<path> textures;
+    path hotspot;
+};
+
+static ExtractedTextures ExtractTexturesAndHotspot(path const &in, path const &tempDir, Rx3Options const &sourceOptions) {
+    ExtractedTextures result;
+    Rx3Container source(in);
+    Rx3Options options = sourceOptions;
+    options.textureFormat = "dds";
+    options.writeTexMetadata = false;
+    options.folderOption = FOLDER_OPTION_NEVER_CREATE;
+    if (source.FindFirstChunk(RX3_CHUNK_TEXTURE)) {
+        path texDir = tempDir / L"textures";
+        create_directories(texDir);
+        ExtractTexturesFromRX3(source, texDir, options);
+        for (auto const &p : directory_iterator(texDir)) {
+            if (ToLower(p.path().extension().wstring()) == L".dds")
+                result.textures.push_back(p.path());
+        }
+    }
+    if (source.FindFirstChunk(RX3_CHUNK_HOTSPOT)) {
+        path hotspotDir = tempDir / L"hotspot";
+        create_directories(hotspotDir);
+        ExtractHotspotFromRX3(source, hotspotDir, options);
+        for (auto const &p : directory_iterator(hotspotDir)) {
+            if (ToLower(p.path().extension().wstring()) == L".hotspot") {
+                result.hotspot = p.path();
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+static bool BuildTexturesAndHotspot(ExtractedTextures const &extracted, path const &out, Rx3Options const &targetOptions) {
+    Rx3Options options = targetOptions;
+    Rx3Container target(options.gameConfig.BigEndian);
+    if (!extracted.textures.empty()) {
+        target.AddChunk(RX3_CHUNK_TEXTURE_BATCH);
+        ImportTexturesToRX3(target, extracted.textures, path(), options);
+    }
+    if (!extracted.hotspot.empty())
+        ImportHotspotToRX3(target, extracted.hotspot, options);
+    target.Save(out);
+    return exists(out);
+}
+
+static bool BuildConvertedRx3(Rx3File const &source, std::list<Rx3File> const &rebuilt, path const &in, Rx3Options const &targetOptions,
+    Rx3FileWriter &writer)
+{
+    bool swapBytes = source.IsBigEndian() != targetOptions.gameConfig.BigEndian;
+    // chunks of the rebuilt parts replace all source chunks of the same types
+    map<uint32_t, Rx3File const *> replacedTypes;
+    for (auto const &r : rebuilt) {
+        for (auto const &c : r.Chunks()) {
+            if (c.type != RX3_CHUNK_NAMES)
+                replacedTypes[c.type] = &r;
+        }
+    }
+    set<uint32_t> unconverted;
+    for (auto const &c : source.Chunks()) {
+        if (swapBytes && c.type != RX3_CHUNK_NAMES && !replacedTypes.contains(c.type))
+            unconverted.insert(c.type);
+    }
+    if (!unconverted.empty()) {
+        string types;
+        for (auto type : unconverted)
+            types += (types.empty() ? "" : ", ") + to_string(type);
+        ErrorMessage("Chunks can't be converted to the target byte order (" + types + "): " + ToUTF8(in.c_str()));
+        return false;
+    }
+    set<Rx3File const *> written;
+    for (auto const &c : source.Chunks()) {
+        auto it = replacedTypes.find(c.type);
+        if (it == replacedTypes.end())
+            writer.AddChunk(c.type, source.ChunkData(c), c.size, c.name);
+        else if (written.insert(it->second).second) {
+            // a rebuilt part goes where its first replaced chunk was
+            for (auto const &rc : it->second->Chunks()) {
+                if (rc.type != RX3_CHUNK_NAMES)
+                    writer.AddChunk(rc.type, it->second->ChunkData(rc), rc.size, rc.name);
+            }
+        }
+    }
+    for (auto const &r : rebuilt) {
+        if (!written.contains(&r)) {
+            for (auto const &rc : r.Chunks()) {
+                if (rc.type != RX3_CHUNK_NAMES)
+                    writer.AddChunk(rc.type, r.ChunkData(rc), rc.size, rc.name);
+            }
+        }
+    }
+    return true;
+}
+
+bool ConvertRx3(path const &in, path const &sourcePath, vector<Rx3ConvertTarget> const &targets, Rx3Options const &sourceOptions) {
+    Rx3File source;
+    if (!source.Open(in)) {
+        ErrorMessage("Failed to read " + ToUTF8(in.c_str()));
+        return false;
+    }
+    bool hasModel = !source.FindChunks(RX3_CHUNK_VERTEX_BUFFER).empty();
+    bool hasTextures = !source.FindChunks(RX3_CHUNK_TEXTURE).empty() || !source.FindChunks(RX3_CHUNK_HOTSPOT).empty();
+    TempFolder temp;
+    Model model;
+    if (hasModel)
+        model = ReadModelFromRX3(in, sourceOptions);
+    std::optional<ExtractedTextures> extracted;
+    // all targets are built before anything is saved, so the source can be closed first (and be overwritten)
+    std::list<pair<path, Rx3FileWriter>> writers;
+    bool result = true;
+    for (size_t i = 0; i < targets.size(); i++) {
+        auto const &target = targets[i];
+        path targetTemp = temp.Path() / to_wstring(i);
+        create_directories(targetTemp);
+        std::list<Rx3File> rebuilt;
+        // a target of the source game keeps the model as it is
+        if (hasModel && target.options.game != sourceOptions.game) {
+            path modelPath = targetTemp / L"model.rx3";
+            if (!ConvertModel(model, sourcePath, modelPath, target.options) || !rebuilt.emplace_back().Open(modelPath)) {
+                ErrorMessage("Failed to convert model: " + ToUTF8(in.c_str()));
+                result = false;
+                continue;
+            }
+            if (SameModelLayout(source, rebuilt.back()))
+                rebuilt.pop_back();
+        }
+        if (hasTextures && source.IsBigEndian() != target.options.gameConfig.BigEndian) {
+            if (!extracted)
+                extracted = ExtractTexturesAndHotspot(in, temp.Path(), sourceOptions);
+            path texturesPath = targetTemp / L"textures.rx3";
+            if (!BuildTexturesAndHotspot(*extracted, texturesPath, target.options) || !rebuilt.emplace_back().Open(texturesPath)) {
+                ErrorMessage("Failed to convert textures: " + ToUTF8(in.c_str()));
+                result = false;
+                continue;
+            }
+        }
+        auto &writer = writers.emplace_back(std::piecewise_construct, std::forward_as_tuple(target.out),
+            std::forward_as_tuple(target.options.gameConfig.BigEndian));
+        if (!BuildConvertedRx3(source, rebuilt, in, target.options, writer.second)) {
+            writers.pop_back();
+            result = false;
+        }
+    }
+    source.Close();
+    for (auto &[out, writer] : writers) {
+        create_directories(out.parent_path());
+        if (!writer.Save(out))
+            result = false;
+    }
+    return result;
+}
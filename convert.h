@@ -0,0 +1,15 @@
+#pragma once
+#include "Rx3Textures.h"
+
+struct Rx3ConvertTarget {
+    path out;
+    Rx3Options options;
+};
+
+// Rewrites an rx3 file made for one game (sourceOptions) for one or more other games. The file and its
+// Model are read once and rebuilt per target; a rebuilt model is only used when its byte order or vertex
+// declarations differ from the source. Textures and hotspots are rebuilt only for targets with a
+// different byte order, every other chunk is copied byte for byte. A target whose byte order differs fails
+// (and is not written) when the file has chunk types that can't be converted. sourcePath is the path
+// recorded in the metadata of rebuilt models.
+bool ConvertRx3(path const &in, path const &sourcePath, vector<Rx3ConvertTarget> const &targets, Rx3Options const &sourceOptions);
@@ -0,0 +1,112 @@
+#include "endianflip.h"
+#include "rx3file.h"
+#include "byteswap.h"
+#include "vertexdecl.h"
+
+using namespace rx3utils;
+
+// 32-bit components swap as 4-byte words, 16-bit ones as 2-byte words, packed types as one 4-byte word
+static bool ReadVertexLayout(Rx3File const &rx3, Rx3FileChunk const &format, uint32_t stride, SwapLayout &layout) {
+    vector<Rx3VertexElement> elements;
+    if (!ReadRx3VertexDeclaration(rx3, format, elements))
+        return false;
+    layout.stride = stride;
+    layout.words.clear();
+    for (auto const &e : elements) {
+        if (e.offset + e.Size() > stride)
+            return false;
+        if (e.componentSize == 0)
+            layout.words.emplace_back(e.offset, 4);
+        else if (e.componentSize > 1) {
+            for (uint32_t c = 0; c < e.count; c++)
+                layout.words.emplace_back(e.offset + c * e.componentSize, e.componentSize);
+        }
+    }
+    return true;
+}
+
+bool FlipRx3Endianness(path const &in, path const &out, set<uint32_t> &unknownTypes, set<uint32_t> &unflippedTypes) {
+    Rx3File source;
+    if (!source.Open(in))
+        return false;
+    // the header, chunk table and names chunk are written by Rx3FileWriter in the target byte order
+    Rx3FileWriter writer(!source.IsBigEndian());
+    auto vertexFormats = source.FindChunks(RX3_CHUNK_VERTEX_FORMAT);
+    size_t vertexBufferIndex = 0;
+    bool failed = false;
+    for (auto const &c : source.Chunks()) {
+        if (c.type == RX3_CHUNK_NAMES)
+            continue;
+        uint8_t const *src = source.ChunkData(c);
+        uint8_t *dst = writer.AddChunk(c.type, src, c.size, c.name).data.data();
+        switch (c.type) {
+        case RX3_CHUNK_METADATA:
+            // written by rx3lib for tools only, its layout isn't known here so it is kept as it is
+            unflippedTypes.insert(c.type);
+            break;
+        case RX3_CHUNK_TEXTURE_BATCH:
+        case RX3_CHUNK_PRIMITIVE_TYPE:
+            SwapBytes32(dst, c.size / 4);
+            break;
+        case RX3_CHUNK_SKELETON:
+            // 16-byte header and 4x4 float matrices, all 32-bit words
+            if (c.size < 16 || c.size % 4) {
+                unknownTypes.insert(c.type);
+                failed = true;
+            }
+            else
+                SwapBytes32(dst, c.size / 4);
+            break;
+        case RX3_CHUNK_VERTEX_FORMAT:
+            // 16-byte header of 32-bit words, then the declaration text
+            if (c.size >= 16)
+                SwapBytes32(dst, 4);
+            break;
+        case RX3_CHUNK_INDEX_BUFFER: {
+            if (c.size < 16)
+                break;
+            uint32_t numIndices = source.Read32(src + 4);
+            uint32_t indexSize = src[8];
+            SwapBytes32(dst, 2);
+            if (16 + size_t(numIndices) * indexSize <= c.size && indexSize == 2)
+                SwapBytes16(dst + 16, numIndices);
+            else if (16 + size_t(numIndices) * indexSize <= c.size && indexSize == 4)
+                SwapBytes32(dst + 16, numIndices);
+            else {
+                unknownTypes.insert(c.type);
+                failed = true;
+            }
+            break;
+        }
+        case RX3_CHUNK_VERTEX_BUFFER: {
+            if (c.size < 16)
+                break;
+            uint32_t numVertices = source.Read32(src + 4);
+            uint32_t vertexSize = source.Read32(src + 8);
+            SwapBytes32(dst, 3);
+            SwapLayout layout;
+            if (vertexBufferIndex >= vertexFormats.size() || 16 + size_t(numVertices) * vertexSize > c.size ||
+                !ReadVertexLayout(source, *vertexFormats[vertexBufferIndex], vertexSize, layout))
+            {
+                unknownTypes.insert(c.type);
+                failed = true;
+            }
+            else
+                SwapBytesStrided(dst + 16, numVertices, layout);
+            vertexBufferIndex++;
+            break;
+        }
+        case RX3_CHUNK_TEXTURE:
+            // console textures are tiled as well as byte-swapped, only -convert (through rx3lib) can port them
+        default:
+            unknownTypes.insert(c.type);
+            failed = true;
+            break;
+        }
+    }
+    source.Close();
+    if (failed)
+        return false;
+    create_directories(out.parent_path());
+    return writer.Save(out);
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include "Rx3Utils.h"
+#include <cstdint>
+
+// Flips an rx3 file between little- and big-endian by swapping the header, the chunk table and the payloads
+// of known chunk types; models are never decoded. Metadata chunks are copied unflipped and added to
+// unflippedTypes. Textures can't be flipped (console textures are also tiled). Returns false (and writes
+// nothing) if the file can't be read or contains chunk types that can't be flipped; these are added to unknownTypes.
+bool FlipRx3Endianness(path const &in, path const &out, set<uint32_t> &unknownTypes, set<uint32_t> &unflippedTypes);
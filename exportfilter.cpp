@@ -0,0 +1,62 @@
+#include "exportfilter.h"
+#include "textures.h"
+
+using namespace rx3utils;
+
+bool ExportFilter::Parse(vector<string> const &only, vector<string> const &namePatterns) {
+    if (!only.empty()) {
+        textures = model = hotspot = false;
+        for (auto const &o : only) {
+            if (o == "texture" || o == "textures")
+                textures = true;
+            else if (o == "model" || o == "models")
+                model = true;
+            else if (o == "hotspot" || o == "hotspots")
+                hotspot = true;
+            else
+                return false;
+        }
+    }
+    names = namePatterns;
+    return true;
+}
+
+vector<Rx3FileChunk const *> SelectExportChunks(Rx3File const &rx3, ExportFilter const &filter) {
+    vector<Rx3FileChunk const *> result;
+    bool selected = false;
+    bool hasModel = false;
+    for (auto const &c : rx3.Chunks()) {
+        bool keep;
+        if (c.type == RX3_CHUNK_NAMES)
+            continue;
+        if (c.type == RX3_CHUNK_TEXTURE_BATCH)
+            keep = filter.textures;
+        else if (c.type == RX3_CHUNK_TEXTURE) {
+            keep = filter.textures;
+            if (keep && !filter.names.empty())
+                keep = !FindTexturePattern(ToLower(c.name), filter.names).empty();
+            selected = selected || keep;
+        }
+        else if (c.type == RX3_CHUNK_HOTSPOT) {
+            keep = filter.hotspot;
+            selected = selected || keep;
+        }
+        else {
+            keep = filter.model;
+            hasModel = hasModel || (keep && c.type == RX3_CHUNK_VERTEX_BUFFER);
+        }
+        if (keep)
+            result.push_back(&c);
+    }
+    if (!selected && !hasModel)
+        result.clear();
+    return result;
+}
+
+bool SaveSelectedChunks(Rx3File const &rx3, vector<Rx3FileChunk const *> const &chunks, path const &filePath) {
+    Rx3FileWriter writer(rx3.IsBigEndian());
+    for (auto const *c : chunks)
+        writer.AddChunk(c->type, rx3.ChunkData(*c), c->size, c->name);
+    writer.UpdateTextureBatchCount();
+    return writer.Save(filePath);
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "rx3file.h"
+
+// -only and -name selection for export. Model chunks are everything that is not a texture, the texture batch,
+// a hotspot or the names chunk; names are wildcard patterns matched against texture names.
+struct ExportFilter {
+    bool textures = true;
+    bool model = true;
+    bool hotspot = true;
+    vector<string> names;
+
+    bool Parse(vector<string> const &only, vector<string> const &namePatterns);
+    bool IsActive() const { return !textures || !model || !hotspot || !names.empty(); }
+};
+
+// The chunks of the mapped file selected by filter, in file order and without the names chunk; empty if no
+// texture, hotspot or model chunk is selected
+vector<Rx3FileChunk const *> SelectExportChunks(Rx3File const &rx3, ExportFilter const &filter);
+// An rx3 with only the selected chunks, for the rx3lib exporters (which only read containers from files)
+bool SaveSelectedChunks(Rx3File const &rx3, vector<Rx3FileChunk const *> const &chunks, path const &filePath);
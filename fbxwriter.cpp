@@ -0,0 +1,577 @@
+#include "fbxwriter.h"
+#include <cmath>
+#include <fstream>
+#include <numbers>
+
+using namespace rx3utils;
+
+namespace {
+
+// Node records with 32-bit offsets (version 7400 and below). Each node starts with its end offset, property
+// count and property size, which are patched when its properties or the node itself are complete.
+class FbxBinaryWriter {
+    struct OpenNode {
+        size_t start;
+        uint32_t numProperties = 0;
+        bool propertiesDone = false;
+        bool hasChildren = false;
+    };
+    vector<OpenNode> mStack;
+public:
+    vector<uint8_t> mData;
+
+    template<typename T> void Put(T const &value) {
+        auto const *bytes = reinterpret_cast<uint8_t const *>(&value);
+        mData.insert(mData.end(), bytes, bytes + sizeof(T));
+    }
+
+    void PutBytes(void const *data, size_t size) {
+        auto const *bytes = static_cast<uint8_t const *>(data);
+        mData.insert(mData.end(), bytes, bytes + size);
+    }
+
+    void Patch32(size_t offset, uint32_t value) {
+        memcpy(&mData[offset], &value, 4);
+    }
+
+    void FinishProperties(OpenNode &node) {
+        if (node.propertiesDone)
+            return;
+        node.propertiesDone = true;
+        Patch32(node.start + 4, node.numProperties);
+        Patch32(node.start + 8, uint32_t(mData.size() - (node.start + 13) - mData[node.start + 12]));
+    }
+
+    void Begin(std::string_view name) {
+        if (!mStack.empty()) {
+            FinishProperties(mStack.back());
+            mStack.back().hasChildren = true;
+        }
+        mStack.push_back({ mData.size() });
+        mData.resize(mData.size() + 12);
+        Put(uint8_t(name.size()));
+        PutBytes(name.data(), name.size());
+    }
+
+    // a null record closes nested lists, and follows nodes without properties
+    void End() {
+        OpenNode node = mStack.back();
+        mStack.pop_back();
+        FinishProperties(node);
+        if (node.hasChildren || node.numProperties == 0)
+            mData.resize(mData.size() + 13);
+        Patch32(node.start, uint32_t(mData.size()));
+    }
+
+    void Property(bool value) { Begin('C'); Put(uint8_t(value ? 1 : 0)); }
+    void Property(int32_t value) { Begin('I'); Put(value); }
+    void Property(int64_t value) { Begin('L'); Put(value); }
+    void Property(double value) { Begin('D'); Put(value); }
+    void Property(std::string_view value) { Begin('S'); Put(uint32_t(value.size())); PutBytes(value.data(), value.size()); }
+    void Property(char const *value) { Property(std::string_view(value)); }
+    void Property(string const &value) { Property(std::string_view(value)); }
+    void Raw(void const *data, size_t size) { Begin('R'); Put(uint32_t(size)); PutBytes(data, size); }
+
+    // uncompressed arrays
+    void Property(vector<double> const &values) { Array('d', values); }
+    void Property(vector<int32_t> const &values) { Array('i', values); }
+
+    template<typename T> void Array(char type, vector<T> const &values) {
+        Begin(type);
+        Put(uint32_t(values.size()));
+        Put(uint32_t(0));
+        Put(uint32_t(values.size() * sizeof(T)));
+        PutBytes(values.data(), values.size() * sizeof(T));
+    }
+
+    // node with only properties
+    template<typename... T> void Leaf(std::string_view name, T const &...values) {
+        Begin(name);
+        (Property(values), ...);
+        End();
+    }
+
+    // Properties70 entry
+    template<typename... T> void P(std::string_view name, std::string_view type, std::string_view label, std::string_view flags,
+        T const &...values)
+    {
+        Leaf("P", name, type, label, flags, values...);
+    }
+
+private:
+    void Begin(char type) {
+        mStack.back().numProperties++;
+        Put(type);
+    }
+};
+
+// names of objects are "<name>\0\1<class>"
+string ObjectName(string const &name, char const *objectClass) {
+    return name + string("\0\1", 2) + objectClass;
+}
+
+vector<double> ToDoubles(SceneMatrix const &m) {
+    return vector<double>(m.begin(), m.end());
+}
+
+// translation, XYZ euler angles in degrees (FBX default rotation order) and scale
+void Decompose(SceneMatrix const &m, double translation[3], double rotation[3], double scaling[3]) {
+    double r[3][3];
+    for (int c = 0; c < 3; c++) {
+        translation[c] = m[12 + c];
+        scaling[c] = std::sqrt(double(m[c * 4]) * m[c * 4] + double(m[c * 4 + 1]) * m[c * 4 + 1] + double(m[c * 4 + 2]) * m[c * 4 + 2]);
+        for (int row = 0; row < 3; row++)
+            r[row][c] = scaling[c] > 0.0 ? m[c * 4 + row] / scaling[c] : 0.0;
+    }
+    double determinant = r[0][0] * (r[1][1] * r[2][2] - r[1][2] * r[2][1]) - r[0][1] * (r[1][0] * r[2][2] - r[1][2] * r[2][0]) +
+        r[0][2] * (r[1][0] * r[2][1] - r[1][1] * r[2][0]);
+    if (determinant < 0.0) {
+        scaling[0] = -scaling[0];
+        for (int row = 0; row < 3; row++)
+            r[row][0] = -r[row][0];
+    }
+    // R = Rz * Ry * Rx
+    double sy = std::clamp(-r[2][0], -1.0, 1.0);
+    if (std::abs(sy) < 0.99999) {
+        rotation[0] = std::atan2(r[2][1], r[2][2]);
+        rotation[1] = std::asin(sy);
+        rotation[2] = std::atan2(r[1][0], r[0][0]);
+    }
+    else {
+        rotation[0] = sy > 0.0 ? std::atan2(r[0][1], r[1][1]) : std::atan2(-r[0][1], r[1][1]);
+        rotation[1] = sy > 0.0 ? std::numbers::pi / 2.0 : -std::numbers::pi / 2.0;
+        rotation[2] = 0.0;
+    }
+    for (int c = 0; c < 3; c++)
+        rotation[c] *= 180.0 / std::numbers::pi;
+}
+
+}
+
+bool WriteFbx(Scene const &scene, path const &filePath) {
+    FbxBinaryWriter fbx;
+    static char const HEADER_MAGIC[] = "Kaydara FBX Binary  ";
+    static uint8_t const FILE_ID[16] = { 0x28, 0xB3, 0x2A, 0xEB, 0xB6, 0x24, 0xCC, 0xC2, 0xBF, 0xC8, 0xB0, 0x2A, 0xA9, 0x2B, 0xFC, 0xF1 };
+    static uint8_t const FOOTER_ID[16] = { 0xFA, 0xBC, 0xAB, 0x09, 0xD0, 0xC8, 0xD4, 0x66, 0xB1, 0x76, 0xFB, 0x83, 0x1C, 0xF7, 0x26, 0x7E };
+    static uint8_t const FOOTER_MAGIC[16] = { 0xF8, 0x5A, 0x8C, 0x6A, 0xDE, 0xF5, 0xD9, 0x7E, 0xEC, 0xE9, 0x0C, 0xE3, 0x75, 0x8F, 0x29, 0x0B };
+    uint32_t const VERSION = 7400;
+    fbx.PutBytes(HEADER_MAGIC, sizeof(HEADER_MAGIC));
+    fbx.Put(uint8_t(0x1A));
+    fbx.Put(uint8_t(0));
+    fbx.Put(VERSION);
+
+    // FILE_ID and FOOTER_ID belong to this creation time
+    fbx.Begin("FBXHeaderExtension");
+    fbx.Leaf("FBXHeaderVersion", int32_t(1003));
+    fbx.Leaf("FBXVersion", int32_t(VERSION));
+    fbx.Begin("CreationTimeStamp");
+    fbx.Leaf("Version", int32_t(1000));
+    fbx.Leaf("Year", int32_t(1970));
+    fbx.Leaf("Month", int32_t(1));
+    fbx.Leaf("Day", int32_t(1));
+    fbx.Leaf("Hour", int32_t(10));
+    fbx.Leaf("Minute", int32_t(0));
+    fbx.Leaf("Second", int32_t(0));
+    fbx.Leaf("Millisecond", int32_t(0));
+    fbx.End();
+    fbx.Leaf("Creator", "rx3c");
+    fbx.End();
+    fbx.Begin("FileId");
+    fbx.Raw(FILE_ID, sizeof(FILE_ID));
+    fbx.End();
+    fbx.Leaf("CreationTime", "1970-01-01 10:00:00:000");
+    fbx.Leaf("Creator", "rx3c");
+
+    fbx.Begin("GlobalSettings");
+    fbx.Leaf("Version", int32_t(1000));
+    fbx.Begin("Properties70");
+    fbx.P("UpAxis", "int", "Integer", "", int32_t(1));
+    fbx.P("UpAxisSign", "int", "Integer", "", int32_t(1));
+    fbx.P("FrontAxis", "int", "Integer", "", int32_t(2));
+    fbx.P("FrontAxisSign", "int", "Integer", "", int32_t(1));
+    fbx.P("CoordAxis", "int", "Integer", "", int32_t(0));
+    fbx.P("CoordAxisSign", "int", "Integer", "", int32_t(1));
+    fbx.P("UnitScaleFactor", "double", "Number", "", 1.0);
+    fbx.End();
+    fbx.End();
+
+    int64_t nextId = 1000000;
+    fbx.Begin("Documents");
+    fbx.Leaf("Count", int32_t(1));
+    fbx.Begin("Document");
+    fbx.Property(nextId++);
+    fbx.Property("");
+    fbx.Property("Scene");
+    fbx.Leaf("RootNode", int64_t(0));
+    fbx.End();
+    fbx.End();
+    fbx.Leaf("References");
+
+    // ids and connections (child, parent) of all objects
+    vector<int64_t> boneModels(scene.bones.size()), boneAttributes(scene.bones.size());
+    for (size_t b = 0; b < scene.bones.size(); b++) {
+        boneModels[b] = nextId++;
+        boneAttributes[b] = nextId++;
+    }
+    vector<SceneMatrix> globals = GlobalBoneMatrices(scene.bones);
+    vector<string> materials;
+    for (auto const &mesh : scene.meshes) {
+        if (!mesh.material.empty() && find(materials.begin(), materials.end(), mesh.material) == materials.end())
+            materials.push_back(mesh.material);
+    }
+    vector<int64_t> materialIds(materials.size());
+    for (auto &id : materialIds)
+        id = nextId++;
+    // skin clusters per mesh, a cluster for each bone with non-zero weights
+    struct Cluster {
+        size_t bone;
+        vector<int32_t> indexes;
+        vector<double> weights;
+    };
+    vector<vector<Cluster>> meshClusters(scene.meshes.size());
+    size_t numSkins = 0, numClusters = 0, numMorphs = 0, numBlendShapes = 0;
+    for (size_t m = 0; m < scene.meshes.size(); m++) {
+        auto const &mesh = scene.meshes[m];
+        size_t numVertices = mesh.NumVertices();
+        numMorphs += mesh.morphs.size();
+        numBlendShapes += mesh.morphs.empty() ? 0 : 1;
+        size_t numInfluences = mesh.numInfluences;
+        if (scene.bones.empty() || !numInfluences || mesh.joints.size() != numVertices * numInfluences ||
+            mesh.weights.size() != numVertices * numInfluences)
+        {
+            continue;
+        }
+        vector<Cluster> clusters(scene.bones.size());
+        // a bone listed twice for a vertex gets one index with the summed weight
+        for (size_t i = 0; i < mesh.joints.size(); i++) {
+            if (mesh.weights[i] <= 0.0f || mesh.joints[i] >= scene.bones.size())
+                continue;
+            auto &cluster = clusters[mesh.joints[i]];
+            int32_t vertex = int32_t(i / numInfluences);
+            if (!cluster.indexes.empty() && cluster.indexes.back() == vertex)
+                cluster.weights.back() += mesh.weights[i];
+            else {
+                cluster.indexes.push_back(vertex);
+                cluster.weights.push_back(mesh.weights[i]);
+            }
+        }
+        for (size_t b = 0; b < clusters.size(); b++) {
+            clusters[b].bone = b;
+            if (!clusters[b].indexes.empty())
+                meshClusters[m].push_back(std::move(clusters[b]));
+        }
+        // meshes whose weights are all zero or out of range get no skin
+        numSkins += meshClusters[m].empty() ? 0 : 1;
+        numClusters += meshClusters[m].size();
+    }
+
+    // object counts per type, the SDK creates property templates from these
+    vector<pair<char const *, size_t>> definitions = {
+        { "GlobalSettings", 1 },
+        { "NodeAttribute", scene.bones.size() },
+        { "Model", scene.bones.size() + scene.meshes.size() },
+        { "Geometry", scene.meshes.size() + numMorphs },
+        { "Material", materials.size() },
+        { "Deformer", numSkins + numClusters + numBlendShapes + numMorphs },
+        { "Pose", numSkins ? 1 : 0 }
+    };
+    size_t numDefinitions = 0;
+    for (auto const &[type, count] : definitions)
+        numDefinitions += count;
+    fbx.Begin("Definitions");
+    fbx.Leaf("Version", int32_t(100));
+    fbx.Leaf("Count", int32_t(numDefinitions));
+    for (auto const &[type, count] : definitions) {
+        if (!count)
+            continue;
+        fbx.Begin("ObjectType");
+        fbx.Property(type);
+        fbx.Leaf("Count", int32_t(count));
+        fbx.End();
+    }
+    fbx.End();
+
+    vector<pair<int64_t, int64_t>> connections;
+    auto parents = SceneBoneParents(scene.bones);
+    for (size_t b = 0; b < scene.bones.size(); b++) {
+        connections.emplace_back(boneAttributes[b], boneModels[b]);
+        connections.emplace_back(boneModels[b], parents[b] >= 0 ? boneModels[parents[b]] : 0);
+    }
+
+    fbx.Begin("Objects");
+    for (size_t b = 0; b < scene.bones.size(); b++) {
+        fbx.Begin("NodeAttribute");
+        fbx.Property(boneAttributes[b]);
+        fbx.Property(ObjectName(scene.bones[b].name, "NodeAttribute"));
+        fbx.Property("LimbNode");
+        fbx.Leaf("TypeFlags", "Skeleton");
+        fbx.End();
+        double t[3], r[3], s[3];
+        Decompose(scene.bones[b].transform, t, r, s);
+        fbx.Begin("Model");
+        fbx.Property(boneModels[b]);
+        fbx.Property(ObjectName(scene.bones[b].name, "Model"));
+        fbx.Property("LimbNode");
+        fbx.Leaf("Version", int32_t(232));
+        fbx.Begin("Properties70");
+        fbx.P("Lcl Translation", "Lcl Translation", "", "A", t[0], t[1], t[2]);
+        fbx.P("Lcl Rotation", "Lcl Rotation", "", "A", r[0], r[1], r[2]);
+        fbx.P("Lcl Scaling", "Lcl Scaling", "", "A", s[0], s[1], s[2]);
+        fbx.End();
+        fbx.Leaf("Shading", true);
+        fbx.Leaf("Culling", "CullingOff");
+        fbx.End();
+    }
+    for (size_t m = 0; m < materials.size(); m++) {
+        fbx.Begin("Material");
+        fbx.Property(materialIds[m]);
+        fbx.Property(ObjectName(materials[m], "Material"));
+        fbx.Property("");
+        fbx.Leaf("Version", int32_t(102));
+        fbx.Leaf("ShadingModel", "phong");
+        fbx.Leaf("MultiLayer", int32_t(0));
+        fbx.Begin("Properties70");
+        fbx.P("DiffuseColor", "Color", "", "A", 0.8, 0.8, 0.8);
+        fbx.End();
+        fbx.End();
+    }
+    vector<pair<int64_t, size_t>> skinnedMeshes; // mesh model, mesh index
+    for (size_t m = 0; m < scene.meshes.size(); m++) {
+        auto const &mesh = scene.meshes[m];
+        size_t numVertices = mesh.NumVertices();
+        int64_t modelId = nextId++, geometryId = nextId++;
+        connections.emplace_back(modelId, 0);
+        connections.emplace_back(geometryId, modelId);
+        if (!mesh.material.empty())
+            connections.emplace_back(materialIds[find(materials.begin(), materials.end(), mesh.material) - materials.begin()], modelId);
+
+        fbx.Begin("Geometry");
+        fbx.Property(geometryId);
+        fbx.Property(ObjectName(mesh.name, "Geometry"));
+        fbx.Property("Mesh");
+        fbx.Leaf("Vertices", vector<double>(mesh.positions.begin(), mesh.positions.end()));
+        // the last index of each polygon is stored as its complement
+        vector<int32_t> polygons(mesh.indices.begin(), mesh.indices.begin() + mesh.indices.size() / 3 * 3);
+        for (size_t i = 2; i < polygons.size(); i += 3)
+            polygons[i] = ~polygons[i];
+        fbx.Leaf("PolygonVertexIndex", polygons);
+        fbx.Leaf("GeometryVersion", int32_t(124));
+        vector<pair<string, int32_t>> layerElements;
+        if (mesh.normals.size() == numVertices * 3) {
+            fbx.Begin("LayerElementNormal");
+            fbx.Property(int32_t(0));
+            fbx.Leaf("Version", int32_t(101));
+            fbx.Leaf("Name", "");
+            fbx.Leaf("MappingInformationType", "ByVertice");
+            fbx.Leaf("ReferenceInformationType", "Direct");
+            fbx.Leaf("Normals", vector<double>(mesh.normals.begin(), mesh.normals.end()));
+            fbx.End();
+            layerElements.emplace_back("LayerElementNormal", 0);
+        }
+        for (size_t s = 0; s < mesh.uvs.size(); s++) {
+            // V has its origin at the bottom
+            vector<double> uvs(mesh.uvs[s].begin(), mesh.uvs[s].end());
+            for (size_t i = 1; i < uvs.size(); i += 2)
+                uvs[i] = 1.0 - uvs[i];
+            fbx.Begin("LayerElementUV");
+            fbx.Property(int32_t(s));
+            fbx.Leaf("Version", int32_t(101));
+            fbx.Leaf("Name", "UVChannel_" + to_string(s + 1));
+            fbx.Leaf("MappingInformationType", "ByVertice");
+            fbx.Leaf("ReferenceInformationType", "Direct");
+            fbx.Leaf("UV", uvs);
+            fbx.End();
+            layerElements.emplace_back("LayerElementUV", int32_t(s));
+        }
+        for (size_t s = 0; s < mesh.colors.size(); s++) {
+            if (mesh.colors[s].size() != numVertices * 4)
+                continue;
+            vector<double> colors(mesh.colors[s].size());
+            for (size_t i = 0; i < colors.size(); i++)
+                colors[i] = mesh.colors[s][i] / 255.0;
+            fbx.Begin("LayerElementColor");
+            fbx.Property(int32_t(s));
+            fbx.Leaf("Version", int32_t(101));
+            fbx.Leaf("Name", s == 0 ? string("Col") : ("Col" + to_string(s)));
+            fbx.Leaf("MappingInformationType", "ByVertice");
+            fbx.Leaf("ReferenceInformationType", "Direct");
+            fbx.Leaf("Colors", colors);
+            fbx.End();
+            layerElements.emplace_back("LayerElementColor", int32_t(s));
+        }
+        if (!mesh.material.empty()) {
+            fbx.Begin("LayerElementMaterial");
+            fbx.Property(int32_t(0));
+            fbx.Leaf("Version", int32_t(101));
+            fbx.Leaf("Name", "");
+            fbx.Leaf("MappingInformationType", "AllSame");
+            fbx.Leaf("ReferenceInformationType", "IndexToDirect");
+            fbx.Leaf("Materials", vector<int32_t>{ 0 });
+            fbx.End();
+            layerElements.emplace_back("LayerElementMaterial", 0);
+        }
+        // layer 0 holds the first element of each type, further uv and color sets get their own layers
+        int32_t numLayers = max<int32_t>(1, int32_t(max(mesh.uvs.size(), mesh.colors.size())));
+        for (int32_t layer = 0; layer < numLayers; layer++) {
+            fbx.Begin("Layer");
+            fbx.Property(layer);
+            fbx.Leaf("Version", int32_t(100));
+            for (auto const &[type, index] : layerElements) {
+                if (index != layer)
+                    continue;
+                fbx.Begin("LayerElement");
+                fbx.Leaf("Type", type);
+                fbx.Leaf("TypedIndex", index);
+                fbx.End();
+            }
+            fbx.End();
+        }
+        fbx.End();
+
+        fbx.Begin("Model");
+        fbx.Property(modelId);
+        fbx.Property(ObjectName(mesh.name, "Model"));
+        fbx.Property("Mesh");
+        fbx.Leaf("Version", int32_t(232));
+        fbx.Begin("Properties70");
+        fbx.P("Lcl Translation", "Lcl Translation", "", "A", 0.0, 0.0, 0.0);
+        fbx.P("Lcl Rotation", "Lcl Rotation", "", "A", 0.0, 0.0, 0.0);
+        fbx.P("Lcl Scaling", "Lcl Scaling", "", "A", 1.0, 1.0, 1.0);
+        fbx.End();
+        fbx.Leaf("Shading", true);
+        fbx.Leaf("Culling", "CullingOff");
+        fbx.End();
+
+        // Transform is the mesh relative to the bone at bind time, TransformLink the bone
+        if (!meshClusters[m].empty()) {
+            int64_t skinId = nextId++;
+            connections.emplace_back(skinId, geometryId);
+            fbx.Begin("Deformer");
+            fbx.Property(skinId);
+            fbx.Property(ObjectName(mesh.name, "Deformer"));
+            fbx.Property("Skin");
+            fbx.Leaf("Version", int32_t(101));
+            fbx.Leaf("Link_DeformAcuracy", 50.0);
+            fbx.End();
+            for (auto const &cluster : meshClusters[m]) {
+                auto const &bone = scene.bones[cluster.bone];
+                int64_t clusterId = nextId++;
+                connections.emplace_back(clusterId, skinId);
+                connections.emplace_back(boneModels[cluster.bone], clusterId);
+                fbx.Begin("Deformer");
+                fbx.Property(clusterId);
+                fbx.Property(ObjectName(bone.name, "SubDeformer"));
+                fbx.Property("Cluster");
+                fbx.Leaf("Version", int32_t(100));
+                fbx.Leaf("UserData", "", "");
+                fbx.Leaf("Indexes", cluster.indexes);
+                fbx.Leaf("Weights", cluster.weights);
+                fbx.Leaf("Transform", ToDoubles(bone.inverseBind));
+                fbx.Leaf("TransformLink", ToDoubles(InvertSceneMatrix(bone.inverseBind)));
+                fbx.End();
+            }
+            skinnedMeshes.emplace_back(modelId, m);
+        }
+
+        // blend shapes: one channel with one shape per morph, shapes store offsets of the moved vertices
+        if (!mesh.morphs.empty()) {
+            int64_t blendShapeId = nextId++;
+            connections.emplace_back(blendShapeId, geometryId);
+            fbx.Begin("Deformer");
+            fbx.Property(blendShapeId);
+            fbx.Property(ObjectName(mesh.name, "Deformer"));
+            fbx.Property("BlendShape");
+            fbx.Leaf("Version", int32_t(100));
+            fbx.End();
+            for (auto const &morph : mesh.morphs) {
+                int64_t channelId = nextId++, shapeId = nextId++;
+                connections.emplace_back(channelId, blendShapeId);
+                connections.emplace_back(shapeId, channelId);
+                vector<int32_t> indexes;
+                vector<double> offsets, normals;
+                bool hasNormals = morph.normals.size() == numVertices * 3 && mesh.normals.size() == numVertices * 3;
+                for (size_t i = 0; i < numVertices && morph.positions.size() == numVertices * 3; i++) {
+                    float d[3], n[3] = {};
+                    for (size_t c = 0; c < 3; c++) {
+                        d[c] = morph.positions[i * 3 + c] - mesh.positions[i * 3 + c];
+                        if (hasNormals)
+                            n[c] = morph.normals[i * 3 + c] - mesh.normals[i * 3 + c];
+                    }
+                    if (d[0] == 0.0f && d[1] == 0.0f && d[2] == 0.0f && n[0] == 0.0f && n[1] == 0.0f && n[2] == 0.0f)
+                        continue;
+                    indexes.push_back(int32_t(i));
+                    offsets.insert(offsets.end(), { d[0], d[1], d[2] });
+                    if (hasNormals)
+                        normals.insert(normals.end(), { n[0], n[1], n[2] });
+                }
+                fbx.Begin("Deformer");
+                fbx.Property(channelId);
+                fbx.Property(ObjectName(morph.name, "SubDeformer"));
+                fbx.Property("BlendShapeChannel");
+                fbx.Leaf("Version", int32_t(100));
+                fbx.Leaf("DeformPercent", 0.0);
+                fbx.Leaf("FullWeights", vector<double>{ 100.0 });
+                fbx.End();
+                fbx.Begin("Geometry");
+                fbx.Property(shapeId);
+                fbx.Property(ObjectName(morph.name, "Geometry"));
+                fbx.Property("Shape");
+                fbx.Leaf("Version", int32_t(100));
+                fbx.Leaf("Indexes", indexes);
+                fbx.Leaf("Vertices", offsets);
+                if (hasNormals)
+                    fbx.Leaf("Normals", normals);
+                fbx.End();
+            }
+        }
+    }
+    // bind pose: global matrices of all bones and skinned meshes
+    if (!skinnedMeshes.empty()) {
+        SceneMatrix const identity = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+        fbx.Begin("Pose");
+        fbx.Property(nextId++);
+        fbx.Property(ObjectName("BindPose", "Pose"));
+        fbx.Property("BindPose");
+        fbx.Leaf("Type", "BindPose");
+        fbx.Leaf("Version", int32_t(100));
+        fbx.Leaf("NbPoseNodes", int32_t(scene.bones.size() + skinnedMeshes.size()));
+        for (auto const &[modelId, m] : skinnedMeshes) {
+            fbx.Begin("PoseNode");
+            fbx.Leaf("Node", modelId);
+            fbx.Leaf("Matrix", ToDoubles(identity));
+            fbx.End();
+        }
+        for (size_t b = 0; b < scene.bones.size(); b++) {
+            fbx.Begin("PoseNode");
+            fbx.Leaf("Node", boneModels[b]);
+            fbx.Leaf("Matrix", ToDoubles(globals[b]));
+            fbx.End();
+        }
+        fbx.End();
+    }
+    fbx.End();
+
+    fbx.Begin("Connections");
+    for (auto const &[child, parent] : connections)
+        fbx.Leaf("C", "OO", child, parent);
+    fbx.End();
+    fbx.Begin("Takes");
+    fbx.Leaf("Current", "");
+    fbx.End();
+
+    // null record ends the top level, then the footer
+    fbx.mData.resize(fbx.mData.size() + 13);
+    fbx.PutBytes(FOOTER_ID, sizeof(FOOTER_ID));
+    fbx.mData.resize(fbx.mData.size() + 4);
+    size_t padding = 16 - fbx.mData.size() % 16;
+    fbx.mData.resize(fbx.mData.size() + padding);
+    fbx.Put(VERSION);
+    fbx.mData.resize(fbx.mData.size() + 120);
+    fbx.PutBytes(FOOTER_MAGIC, sizeof(FOOTER_MAGIC));
+
+    std::ofstream file(filePath, std::ios::binary);
+    if (!file)
+        return false;
+    file.write(reinterpret_cast<char const *>(fbx.mData.data()), fbx.mData.size());
+    return file.good();
+}
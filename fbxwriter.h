@@ -0,0 +1,7 @@
+#pragma once
+#include "scene.h"
+
+// Binary FBX 7.4 without the FBX SDK: mesh geometry (normals, uv sets, colors as direct per-vertex layers),
+// materials by name, bones as LimbNodes, a skin with one cluster per influencing bone, a bind pose and one
+// blend shape channel per morph target. Timestamps and ids are fixed, so the output is reproducible.
+bool WriteFbx(Scene const &scene, path const &filePath);
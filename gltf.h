@@ -0,0 +1,12 @@
+#pragma once
+#include "scene.h"
+
+// glTF 2.0 binary (GLB). Every Scene array is one buffer view in the BIN chunk; bones are nodes with
+// matrices, skinned meshes share one skin, morph targets carry their names in mesh extras.targetNames.
+bool WriteGlb(Scene const &scene, path const &filePath);
+
+// .glb or .gltf (external or base64 buffers). Accessors are read from the mapped buffers, tightly packed float
+// data is copied as a whole. Skin joints of all skins become the bones; without skins and meshes every node
+// is a bone. Transforms of unskinned mesh nodes are applied to their vertices. Models keep only the node rest
+// pose, skin inverse bind matrices that don't match it are reported.
+bool ReadGltf(path const &filePath, Scene &scene);
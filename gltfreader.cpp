@@ -0,0 +1,486 @@
+#include "gltf.h"
+#include "errormsg.h"
+#include "mappedfile.h"
+#include "nlohmann/json.hpp"
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <numeric>
+
+using namespace rx3utils;
+
+namespace {
+
+using Matrix = SceneMatrix;
+
+Matrix const IDENTITY = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+vector<uint8_t> DecodeBase64(std::string_view text) {
+    vector<uint8_t> result;
+    result.reserve(text.size() * 3 / 4);
+    uint32_t bits = 0;
+    int numBits = 0;
+    for (char c : text) {
+        int value;
+        if (c >= 'A' && c <= 'Z') value = c - 'A';
+        else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+        else if (c >= '0' && c <= '9') value = c - '0' + 52;
+        else if (c == '+') value = 62;
+        else if (c == '/') value = 63;
+        else break;
+        bits = (bits << 6) | uint32_t(value);
+        numBits += 6;
+        if (numBits >= 8) {
+            numBits -= 8;
+            result.push_back(uint8_t(bits >> numBits));
+        }
+    }
+    return result;
+}
+
+struct Buffer {
+    uint8_t const *data = nullptr;
+    size_t size = 0;
+};
+
+class GltfReader {
+    nlohmann::json mJson;
+    vector<Buffer> mBuffers;
+    std::list<MappedFile> mMappedBuffers;
+    std::list<vector<uint8_t>> mDecodedBuffers;
+    vector<Matrix> mGlobals;
+    vector<int> mParents;
+    MappedFile mFile;
+public:
+    // bones whose skin inverse bind matrix isn't the inverse of their global rest matrix
+    vector<string> mBindMismatches;
+
+    bool Open(path const &filePath) {
+        if (!mFile.Open(filePath) || mFile.Size() < 12)
+            return false;
+        uint8_t const *data = mFile.Data();
+        std::string_view jsonText;
+        Buffer bin;
+        if (memcmp(data, "glTF", 4) == 0) {
+            // header, JSON chunk, optional BIN chunk
+            uint32_t header[3], chunk[2];
+            memcpy(header, data, 12);
+            size_t size = min<size_t>(header[2], mFile.Size());
+            size_t offset = 12;
+            while (offset + 8 <= size) {
+                memcpy(chunk, data + offset, 8);
+                offset += 8;
+                if (chunk[0] > size - offset)
+                    return false;
+                if (chunk[1] == 0x4E4F534A)
+                    jsonText = std::string_view(reinterpret_cast<char const *>(data + offset), chunk[0]);
+                else if (chunk[1] == 0x004E4942 && !bin.data)
+                    bin = { data + offset, chunk[0] };
+                offset += (size_t(chunk[0]) + 3) & ~size_t(3);
+            }
+        }
+        else
+            jsonText = std::string_view(reinterpret_cast<char const *>(data), mFile.Size());
+        mJson = nlohmann::json::parse(jsonText, nullptr, false);
+        if (mJson.is_discarded() || !mJson.is_object())
+            return false;
+        for (auto const &buffer : mJson.value("buffers", nlohmann::json::array())) {
+            string uri = buffer.value("uri", "");
+            if (uri.empty())
+                mBuffers.push_back(bin);
+            else if (uri.starts_with("data:")) {
+                auto comma = uri.find(',');
+                auto &decoded = mDecodedBuffers.emplace_back(DecodeBase64(comma == string::npos ? "" : std::string_view(uri).substr(comma + 1)));
+                mBuffers.push_back({ decoded.data(), decoded.size() });
+            }
+            else {
+                auto &mapped = mMappedBuffers.emplace_back();
+                if (!mapped.Open(filePath.parent_path() / AtoW(UnescapeUri(uri))))
+                    return false;
+                mBuffers.push_back({ mapped.Data(), mapped.Size() });
+            }
+        }
+        return true;
+    }
+
+    static string UnescapeUri(string const &uri) {
+        string result;
+        for (size_t i = 0; i < uri.size(); i++) {
+            if (uri[i] == '%' && i + 2 < uri.size()) {
+                result += char(std::stoi(uri.substr(i + 1, 2), nullptr, 16));
+                i += 2;
+            }
+            else
+                result += uri[i];
+        }
+        return result;
+    }
+
+    // Element pointer and stride of an accessor, validated against its buffer
+    struct View {
+        uint8_t const *data = nullptr;
+        size_t count = 0;
+        size_t stride = 0;
+        size_t numComponents = 0;
+        int componentType = 0;
+        bool normalized = false;
+    };
+
+    bool GetView(nlohmann::json const &index, View &view) const {
+        static map<string, size_t> const numComponents = {
+            { "SCALAR", 1 }, { "VEC2", 2 }, { "VEC3", 3 }, { "VEC4", 4 }, { "MAT2", 4 }, { "MAT3", 9 }, { "MAT4", 16 }
+        };
+        auto const &accessors = mJson.at("accessors");
+        if (!index.is_number_unsigned() || index.get<size_t>() >= accessors.size())
+            return false;
+        auto const &accessor = accessors[index.get<size_t>()];
+        auto type = numComponents.find(accessor.value("type", ""));
+        if (type == numComponents.end() || !accessor.contains("bufferView"))
+            return false;
+        view.numComponents = type->second;
+        view.componentType = accessor.value("componentType", 0);
+        view.normalized = accessor.value("normalized", false);
+        size_t componentSize = view.componentType == 5126 || view.componentType == 5125 ? 4 :
+            (view.componentType == 5122 || view.componentType == 5123 ? 2 : 1);
+        size_t elementSize = componentSize * view.numComponents;
+        size_t viewIndex = accessor["bufferView"].get<size_t>();
+        if (viewIndex >= mJson.at("bufferViews").size())
+            return false;
+        auto const &bufferView = mJson.at("bufferViews")[viewIndex];
+        size_t bufferIndex = bufferView.value("buffer", size_t(0));
+        if (bufferIndex >= mBuffers.size())
+            return false;
+        Buffer const &buffer = mBuffers[bufferIndex];
+        // 64-bit and division-based so that no offset, length or count can wrap
+        uint64_t viewOffset = bufferView.value("byteOffset", uint64_t(0));
+        uint64_t length = bufferView.value("byteLength", uint64_t(0));
+        uint64_t offset = accessor.value("byteOffset", uint64_t(0));
+        uint64_t count = accessor.value("count", uint64_t(0));
+        uint64_t stride = bufferView.value("byteStride", uint64_t(elementSize));
+        if (viewOffset > buffer.size || length > buffer.size - viewOffset || offset > length || stride < elementSize)
+            return false;
+        if (count && (elementSize > length - offset || count - 1 > (length - offset - elementSize) / stride))
+            return false;
+        view.count = size_t(count);
+        view.stride = size_t(stride);
+        view.data = buffer.data + size_t(viewOffset + offset);
+        return true;
+    }
+
+    // Any component type as float, normalized integers are scaled to [0, 1] / [-1, 1]
+    bool ReadFloats(nlohmann::json const &index, size_t numComponents, vector<float> &out) const {
+        View view;
+        if (!GetView(index, view) || view.numComponents < numComponents)
+            return false;
+        out.resize(view.count * numComponents);
+        if (view.componentType == 5126 && view.stride == numComponents * 4) {
+            if (!out.empty())
+                memcpy(out.data(), view.data, out.size() * 4);
+            return true;
+        }
+        for (size_t i = 0; i < view.count; i++) {
+            uint8_t const *element = view.data + i * view.stride;
+            for (size_t c = 0; c < numComponents; c++) {
+                float value;
+                switch (view.componentType) {
+                case 5126: memcpy(&value, element + c * 4, 4); break;
+                case 5121: value = element[c] / (view.normalized ? 255.0f : 1.0f); break;
+                case 5120: value = view.normalized ? max(int8_t(element[c]) / 127.0f, -1.0f) : float(int8_t(element[c])); break;
+                case 5123: { uint16_t v; memcpy(&v, element + c * 2, 2); value = v / (view.normalized ? 65535.0f : 1.0f); break; }
+                case 5122: { int16_t v; memcpy(&v, element + c * 2, 2); value = view.normalized ? max(v / 32767.0f, -1.0f) : float(v); break; }
+                default: return false;
+                }
+                out[i * numComponents + c] = value;
+            }
+        }
+        return true;
+    }
+
+    bool ReadIntegers(nlohmann::json const &index, size_t numComponents, vector<uint32_t> &out) const {
+        View view;
+        if (!GetView(index, view) || view.numComponents < numComponents)
+            return false;
+        out.resize(view.count * numComponents);
+        for (size_t i = 0; i < view.count; i++) {
+            uint8_t const *element = view.data + i * view.stride;
+            for (size_t c = 0; c < numComponents; c++) {
+                switch (view.componentType) {
+                case 5121: out[i * numComponents + c] = element[c]; break;
+                case 5123: { uint16_t v; memcpy(&v, element + c * 2, 2); out[i * numComponents + c] = v; break; }
+                case 5125: memcpy(&out[i * numComponents + c], element + c * 4, 4); break;
+                default: return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static Matrix LocalMatrix(nlohmann::json const &node) {
+        if (node.contains("matrix") && node["matrix"].size() == 16)
+            return node["matrix"].get<Matrix>();
+        auto t = node.value("translation", std::array<float, 3>{ 0, 0, 0 });
+        auto r = node.value("rotation", std::array<float, 4>{ 0, 0, 0, 1 });
+        auto s = node.value("scale", std::array<float, 3>{ 1, 1, 1 });
+        float x = r[0], y = r[1], z = r[2], w = r[3];
+        return {
+            (1 - 2 * (y * y + z * z)) * s[0], (2 * (x * y + z * w)) * s[0], (2 * (x * z - y * w)) * s[0], 0,
+            (2 * (x * y - z * w)) * s[1], (1 - 2 * (x * x + z * z)) * s[1], (2 * (y * z + x * w)) * s[1], 0,
+            (2 * (x * z + y * w)) * s[2], (2 * (y * z - x * w)) * s[2], (1 - 2 * (x * x + y * y)) * s[2], 0,
+            t[0], t[1], t[2], 1
+        };
+    }
+
+    // global * inverseBind is the identity up to float error (translations relative to the bone's distance from the origin)
+    static bool IsInverse(Matrix const &global, Matrix const &inverseBind) {
+        Matrix product = MultiplySceneMatrices(global, inverseBind);
+        float scale = max({ 1.0f, std::abs(global[12]), std::abs(global[13]), std::abs(global[14]) });
+        for (int i = 0; i < 16; i++) {
+            if (std::abs(product[i] - IDENTITY[i]) > (i >= 12 ? 1e-3f * scale : 1e-3f))
+                return false;
+        }
+        return true;
+    }
+
+    bool Read(Scene &scene) {
+        scene = Scene();
+        auto const &nodes = mJson.value("nodes", nlohmann::json::array());
+        mParents.assign(nodes.size(), -1);
+        for (size_t n = 0; n < nodes.size(); n++) {
+            for (auto const &child : nodes[n].value("children", nlohmann::json::array())) {
+                size_t c = child.get<size_t>();
+                if (c >= nodes.size() || mParents[c] != -1 || c == n)
+                    return false;
+                mParents[c] = int(n);
+            }
+        }
+        // nodes in hierarchy order, so parents (and parent bones) come first
+        vector<size_t> order;
+        for (size_t n = 0; n < nodes.size(); n++) {
+            if (mParents[n] == -1)
+                order.push_back(n);
+        }
+        for (size_t i = 0; i < order.size(); i++) {
+            for (auto const &child : nodes[order[i]].value("children", nlohmann::json::array()))
+                order.push_back(child.get<size_t>());
+        }
+        if (order.size() != nodes.size())
+            return false;
+        mGlobals.assign(nodes.size(), IDENTITY);
+        for (size_t n : order)
+            mGlobals[n] = mParents[n] >= 0 ? MultiplySceneMatrices(mGlobals[mParents[n]], LocalMatrix(nodes[n])) : LocalMatrix(nodes[n]);
+
+        auto const &skins = mJson.value("skins", nlohmann::json::array());
+        vector<bool> isBone(nodes.size(), false);
+        bool hasMeshes = false;
+        for (auto const &node : nodes)
+            hasMeshes = hasMeshes || node.contains("mesh");
+        if (skins.empty() && !hasMeshes)
+            isBone.assign(nodes.size(), true);
+        for (auto const &skin : skins) {
+            for (auto const &joint : skin.value("joints", nlohmann::json::array())) {
+                if (joint.get<size_t>() >= nodes.size())
+                    return false;
+                isBone[joint.get<size_t>()] = true;
+            }
+        }
+        vector<int> boneIndex(nodes.size(), -1);
+        for (size_t n : order) {
+            if (!isBone[n])
+                continue;
+            boneIndex[n] = int(scene.bones.size());
+            SceneBone &bone = scene.bones.emplace_back();
+            bone.name = nodes[n].value("name", "bone" + to_string(n));
+            int parent = mParents[n];
+            while (parent >= 0 && !isBone[parent])
+                parent = mParents[parent];
+            // transforms of non-bone ancestors are folded into the bone
+            bone.transform = parent >= 0 ? LocalMatrix(nodes[n]) : mGlobals[n];
+            if (parent >= 0 && mParents[n] != parent) {
+                Matrix between = IDENTITY;
+                for (int a = mParents[n]; a != parent; a = mParents[a])
+                    between = MultiplySceneMatrices(LocalMatrix(nodes[a]), between);
+                bone.transform = MultiplySceneMatrices(between, bone.transform);
+            }
+            bone.parent = parent >= 0 ? boneIndex[parent] : -1;
+        }
+        // per skin, joint index -> bone index; inverse bind matrices from the skin
+        vector<vector<uint16_t>> skinBones(skins.size());
+        for (size_t s = 0; s < skins.size(); s++) {
+            auto const &joints = skins[s].value("joints", nlohmann::json::array());
+            vector<float> inverseBinds;
+            if (skins[s].contains("inverseBindMatrices") && !ReadFloats(skins[s]["inverseBindMatrices"], 16, inverseBinds))
+                return false;
+            for (size_t j = 0; j < joints.size(); j++) {
+                int b = boneIndex[joints[j].get<size_t>()];
+                skinBones[s].push_back(uint16_t(b));
+                if (inverseBinds.size() >= (j + 1) * 16) {
+                    memcpy(scene.bones[b].inverseBind.data(), &inverseBinds[j * 16], 64);
+                    if (!IsInverse(mGlobals[joints[j].get<size_t>()], scene.bones[b].inverseBind))
+                        mBindMismatches.push_back(scene.bones[b].name);
+                }
+            }
+        }
+
+        auto const &meshes = mJson.value("meshes", nlohmann::json::array());
+        auto const &materials = mJson.value("materials", nlohmann::json::array());
+        for (size_t n : order) {
+            auto const &node = nodes[n];
+            if (!node.contains("mesh") || node["mesh"].get<size_t>() >= meshes.size())
+                continue;
+            auto const &mesh = meshes[node["mesh"].get<size_t>()];
+            int skin = node.contains("skin") && node["skin"].get<size_t>() < skins.size() ? node["skin"].get<int>() : -1;
+            auto const &primitives = mesh.value("primitives", nlohmann::json::array());
+            vector<string> targetNames;
+            if (mesh.contains("extras") && mesh["extras"].contains("targetNames"))
+                targetNames = mesh["extras"]["targetNames"].get<vector<string>>();
+            string name = node.value("name", mesh.value("name", "mesh" + to_string(n)));
+            for (size_t p = 0; p < primitives.size(); p++) {
+                if (!ReadPrimitive(primitives[p], materials, skin >= 0 ? &skinBones[skin] : nullptr, targetNames, scene))
+                    return false;
+                auto &sceneMesh = scene.meshes.back();
+                sceneMesh.name = primitives.size() == 1 ? name : (name + "_" + to_string(p));
+                if (skin < 0 && mGlobals[n] != IDENTITY)
+                    TransformMesh(sceneMesh, mGlobals[n]);
+            }
+        }
+        return true;
+    }
+
+    bool ReadPrimitive(nlohmann::json const &primitive, nlohmann::json const &materials, vector<uint16_t> const *skinBones,
+        vector<string> const &targetNames, Scene &scene)
+    {
+        int mode = primitive.value("mode", 4);
+        auto const &attributes = primitive.value("attributes", nlohmann::json::object());
+        if ((mode != 4 && mode != 5 && mode != 6) || !attributes.contains("POSITION"))
+            return true;
+        SceneMesh &mesh = scene.meshes.emplace_back();
+        if (!ReadFloats(attributes["POSITION"], 3, mesh.positions))
+            return false;
+        size_t numVertices = mesh.NumVertices();
+        if (attributes.contains("NORMAL") && (!ReadFloats(attributes["NORMAL"], 3, mesh.normals) || mesh.normals.size() != numVertices * 3))
+            return false;
+        for (size_t s = 0; attributes.contains("TEXCOORD_" + to_string(s)); s++) {
+            if (!ReadFloats(attributes["TEXCOORD_" + to_string(s)], 2, mesh.uvs.emplace_back()) || mesh.uvs.back().size() != numVertices * 2)
+                return false;
+        }
+        for (size_t s = 0; attributes.contains("COLOR_" + to_string(s)); s++) {
+            auto const &accessor = attributes["COLOR_" + to_string(s)];
+            View view;
+            vector<float> colors;
+            if (!GetView(accessor, view) || !ReadFloats(accessor, view.numComponents, colors) || view.count != numVertices)
+                return false;
+            auto &set = mesh.colors.emplace_back(numVertices * 4, uint8_t(255));
+            for (size_t i = 0; i < numVertices; i++) {
+                for (size_t c = 0; c < view.numComponents && c < 4; c++)
+                    set[i * 4 + c] = uint8_t(std::lround(std::clamp(colors[i * view.numComponents + c], 0.0f, 1.0f) * 255.0f));
+            }
+        }
+        // JOINTS_n/WEIGHTS_n sets of four are joined into one list of influences per vertex
+        size_t numSets = 0;
+        while (skinBones && attributes.contains("JOINTS_" + to_string(numSets)) && attributes.contains("WEIGHTS_" + to_string(numSets)))
+            numSets++;
+        mesh.numInfluences = uint32_t(numSets * 4);
+        mesh.joints.resize(numVertices * mesh.numInfluences);
+        mesh.weights.resize(numVertices * mesh.numInfluences);
+        for (size_t set = 0; set < numSets; set++) {
+            vector<uint32_t> joints;
+            vector<float> weights;
+            if (!ReadIntegers(attributes["JOINTS_" + to_string(set)], 4, joints) || !ReadFloats(attributes["WEIGHTS_" + to_string(set)], 4, weights) ||
+                joints.size() != numVertices * 4 || weights.size() != numVertices * 4)
+            {
+                return false;
+            }
+            for (size_t i = 0; i < joints.size(); i++) {
+                if (joints[i] >= skinBones->size())
+                    return false;
+                // glTF has no per-vertex influence count, slots with weight 0 are unused
+                mesh.joints[(i / 4) * mesh.numInfluences + set * 4 + i % 4] = weights[i] > 0.0f ? (*skinBones)[joints[i]] : SCENE_NO_JOINT;
+                mesh.weights[(i / 4) * mesh.numInfluences + set * 4 + i % 4] = weights[i];
+            }
+        }
+        vector<uint32_t> indices;
+        if (primitive.contains("indices")) {
+            if (!ReadIntegers(primitive["indices"], 1, indices))
+                return false;
+        }
+        else {
+            indices.resize(numVertices);
+            std::iota(indices.begin(), indices.end(), 0);
+        }
+        for (uint32_t index : indices) {
+            if (index >= numVertices)
+                return false;
+        }
+        if (mode == 4)
+            mesh.indices = std::move(indices);
+        else {
+            // strips and fans as triangle lists
+            for (size_t i = 2; i < indices.size(); i++) {
+                if (mode == 6)
+                    mesh.indices.insert(mesh.indices.end(), { indices[0], indices[i - 1], indices[i] });
+                else if (i % 2)
+                    mesh.indices.insert(mesh.indices.end(), { indices[i - 1], indices[i - 2], indices[i] });
+                else
+                    mesh.indices.insert(mesh.indices.end(), { indices[i - 2], indices[i - 1], indices[i] });
+            }
+        }
+        if (primitive.contains("material") && primitive["material"].get<size_t>() < materials.size())
+            mesh.material = materials[primitive["material"].get<size_t>()].value("name", "material" + to_string(primitive["material"].get<size_t>()));
+        auto const &targets = primitive.value("targets", nlohmann::json::array());
+        for (size_t t = 0; t < targets.size(); t++) {
+            SceneMorph &morph = mesh.morphs.emplace_back();
+            morph.name = t < targetNames.size() ? targetNames[t] : ("target" + to_string(t));
+            if (targets[t].contains("POSITION")) {
+                if (!ReadFloats(targets[t]["POSITION"], 3, morph.positions) || morph.positions.size() != numVertices * 3)
+                    return false;
+            }
+            else
+                morph.positions.assign(numVertices * 3, 0.0f);
+            if (targets[t].contains("NORMAL") && (!ReadFloats(targets[t]["NORMAL"], 3, morph.normals) || morph.normals.size() != numVertices * 3))
+                return false;
+            // targets store offsets, Scene morphs are absolute
+            for (size_t i = 0; i < morph.positions.size(); i++)
+                morph.positions[i] += mesh.positions[i];
+            for (size_t i = 0; i < morph.normals.size() && mesh.normals.size() == morph.normals.size(); i++)
+                morph.normals[i] += mesh.normals[i];
+        }
+        return true;
+    }
+
+    static void TransformMesh(SceneMesh &mesh, Matrix const &m) {
+        auto Transform = [&](vector<float> &values, float w) {
+            for (size_t i = 0; i + 2 < values.size(); i += 3) {
+                float x = values[i], y = values[i + 1], z = values[i + 2];
+                values[i] = m[0] * x + m[4] * y + m[8] * z + m[12] * w;
+                values[i + 1] = m[1] * x + m[5] * y + m[9] * z + m[13] * w;
+                values[i + 2] = m[2] * x + m[6] * y + m[10] * z + m[14] * w;
+            }
+        };
+        Transform(mesh.positions, 1.0f);
+        Transform(mesh.normals, 0.0f);
+        for (auto &morph : mesh.morphs) {
+            Transform(morph.positions, 1.0f);
+            Transform(morph.normals, 0.0f);
+        }
+    }
+};
+
+}
+
+bool ReadGltf(path const &filePath, Scene &scene) {
+    GltfReader reader;
+    try {
+        if (!reader.Open(filePath) || !reader.Read(scene))
+            return false;
+        // Model bones have no bind matrices, the rx3 is built from the node rest pose
+        if (!reader.mBindMismatches.empty()) {
+            ErrorMessage(ToUTF8(filePath.c_str()) + ": the skin bind pose of " + to_string(reader.mBindMismatches.size()) +
+                " bone(s) (" + reader.mBindMismatches.front() + ", ...) differs from the node rest pose, the rest pose is used");
+        }
+        return true;
+    }
+    catch (std::exception const &) {
+        // wrong value types in the JSON, malformed buffer URIs
+        return false;
+    }
+}
@@ -0,0 +1,239 @@
+#include "gltf.h"
+#include "nlohmann/json.hpp"
+#include <fstream>
+#include <memory>
+#include <numeric>
+
+using namespace rx3utils;
+
+namespace {
+
+enum GltfComponentType {
+    GLTF_UNSIGNED_BYTE = 5121,
+    GLTF_UNSIGNED_SHORT = 5123,
+    GLTF_UNSIGNED_INT = 5125,
+    GLTF_FLOAT = 5126
+};
+
+enum GltfBufferTarget {
+    GLTF_ARRAY_BUFFER = 34962,
+    GLTF_ELEMENT_ARRAY_BUFFER = 34963
+};
+
+// arrays are not copied into one buffer, they are written from the Scene after the JSON chunk; arrays that
+// don't exist in the Scene are kept alive by Keep until then
+class GlbBuilder {
+public:
+    nlohmann::ordered_json mJson;
+    vector<pair<void const *, size_t>> mPieces;
+    vector<std::shared_ptr<void>> mOwned;
+    size_t mBinSize = 0;
+
+    GlbBuilder() {
+        mJson["asset"] = { { "version", "2.0" }, { "generator", "rx3c" } };
+        mJson["bufferViews"] = nlohmann::ordered_json::array();
+        mJson["accessors"] = nlohmann::ordered_json::array();
+    }
+
+    size_t AddView(void const *data, size_t size, int target) {
+        static uint8_t const zeros[4] = {};
+        if (mBinSize % 4) {
+            mPieces.emplace_back(zeros, 4 - mBinSize % 4);
+            mBinSize += 4 - mBinSize % 4;
+        }
+        nlohmann::ordered_json view = { { "buffer", 0 }, { "byteOffset", mBinSize }, { "byteLength", size } };
+        if (target)
+            view["target"] = target;
+        mPieces.emplace_back(data, size);
+        mBinSize += size;
+        mJson["bufferViews"].push_back(view);
+        return mJson["bufferViews"].size() - 1;
+    }
+
+    template<typename T> size_t AddAccessor(vector<T> const &items, int componentType, char const *type, size_t numComponents,
+        int target, bool normalized = false)
+    {
+        nlohmann::ordered_json accessor = {
+            { "bufferView", AddView(items.data(), items.size() * sizeof(T), target) },
+            { "componentType", componentType },
+            { "count", items.size() / numComponents },
+            { "type", type }
+        };
+        if (normalized)
+            accessor["normalized"] = true;
+        mJson["accessors"].push_back(accessor);
+        return mJson["accessors"].size() - 1;
+    }
+
+    template<typename T> vector<T> const &Keep(vector<T> &&items) {
+        auto owned = std::make_shared<vector<T>>(std::move(items));
+        mOwned.push_back(owned);
+        return *owned;
+    }
+
+    // POSITION accessors (base and morph targets) require bounds
+    size_t AddPositions(vector<float> const &positions) {
+        size_t index = AddAccessor(positions, GLTF_FLOAT, "VEC3", 3, GLTF_ARRAY_BUFFER);
+        float minimum[3] = { 0.0f, 0.0f, 0.0f }, maximum[3] = { 0.0f, 0.0f, 0.0f };
+        for (size_t i = 0; i < positions.size(); i++) {
+            float value = positions[i];
+            size_t c = i % 3;
+            minimum[c] = i < 3 ? value : min(minimum[c], value);
+            maximum[c] = i < 3 ? value : max(maximum[c], value);
+        }
+        mJson["accessors"][index]["min"] = minimum;
+        mJson["accessors"][index]["max"] = maximum;
+        return index;
+    }
+};
+
+bool IsIdentity(std::array<float, 16> const &m) {
+    for (size_t i = 0; i < 16; i++) {
+        if (m[i] != ((i % 5) == 0 ? 1.0f : 0.0f))
+            return false;
+    }
+    return true;
+}
+
+}
+
+bool WriteGlb(Scene const &scene, path const &filePath) {
+    GlbBuilder glb;
+    auto &json = glb.mJson;
+    auto nodes = nlohmann::ordered_json::array();
+    auto roots = nlohmann::ordered_json::array();
+    vector<vector<size_t>> children(scene.bones.size());
+    // parent cycles are broken, so there is a root whenever there are bones and the node graph is a forest
+    auto parents = SceneBoneParents(scene.bones);
+    for (size_t b = 0; b < scene.bones.size(); b++) {
+        if (parents[b] >= 0)
+            children[parents[b]].push_back(b);
+        else
+            roots.push_back(b);
+    }
+    for (size_t b = 0; b < scene.bones.size(); b++) {
+        nlohmann::ordered_json node = { { "name", scene.bones[b].name } };
+        if (!IsIdentity(scene.bones[b].transform))
+            node["matrix"] = scene.bones[b].transform;
+        if (!children[b].empty())
+            node["children"] = children[b];
+        nodes.push_back(node);
+    }
+    int skin = -1;
+    vector<std::array<float, 16>> inverseBinds;
+    if (!scene.bones.empty()) {
+        for (auto const &bone : scene.bones)
+            inverseBinds.push_back(bone.inverseBind);
+        vector<size_t> joints(scene.bones.size());
+        std::iota(joints.begin(), joints.end(), 0);
+        size_t accessor = glb.AddAccessor(inverseBinds, GLTF_FLOAT, "MAT4", 1, 0);
+        json["skins"] = { { { "inverseBindMatrices", accessor }, { "joints", joints }, { "skeleton", roots.front() } } };
+        skin = 0;
+    }
+    vector<string> materials;
+    auto meshes = nlohmann::ordered_json::array();
+    for (auto const &mesh : scene.meshes) {
+        if (mesh.positions.empty())
+            continue;
+        nlohmann::ordered_json attributes;
+        attributes["POSITION"] = glb.AddPositions(mesh.positions);
+        if (!mesh.normals.empty())
+            attributes["NORMAL"] = glb.AddAccessor(mesh.normals, GLTF_FLOAT, "VEC3", 3, GLTF_ARRAY_BUFFER);
+        for (size_t s = 0; s < mesh.uvs.size(); s++)
+            attributes["TEXCOORD_" + to_string(s)] = glb.AddAccessor(mesh.uvs[s], GLTF_FLOAT, "VEC2", 2, GLTF_ARRAY_BUFFER);
+        for (size_t s = 0; s < mesh.colors.size(); s++)
+            attributes["COLOR_" + to_string(s)] = glb.AddAccessor(mesh.colors[s], GLTF_UNSIGNED_BYTE, "VEC4", 4, GLTF_ARRAY_BUFFER, true);
+        bool skinned = skin >= 0 && mesh.numInfluences > 0;
+        // influences go in sets of four, the last set is padded with zero weights
+        for (size_t set = 0; skinned && set * 4 < mesh.numInfluences; set++) {
+            size_t numVertices = mesh.NumVertices();
+            vector<uint16_t> joints(numVertices * 4, 0);
+            vector<float> weights(numVertices * 4, 0.0f);
+            for (size_t i = 0; i < numVertices; i++) {
+                for (size_t w = set * 4; w < set * 4 + 4 && w < mesh.numInfluences; w++) {
+                    if (mesh.joints[i * mesh.numInfluences + w] != SCENE_NO_JOINT)
+                        joints[i * 4 + w % 4] = mesh.joints[i * mesh.numInfluences + w];
+                    weights[i * 4 + w % 4] = mesh.weights[i * mesh.numInfluences + w];
+                }
+            }
+            attributes["JOINTS_" + to_string(set)] = glb.AddAccessor(glb.Keep(std::move(joints)), GLTF_UNSIGNED_SHORT, "VEC4", 4, GLTF_ARRAY_BUFFER);
+            attributes["WEIGHTS_" + to_string(set)] = glb.AddAccessor(glb.Keep(std::move(weights)), GLTF_FLOAT, "VEC4", 4, GLTF_ARRAY_BUFFER);
+        }
+        nlohmann::ordered_json primitive = { { "attributes", attributes } };
+        if (!mesh.indices.empty())
+            primitive["indices"] = glb.AddAccessor(mesh.indices, GLTF_UNSIGNED_INT, "SCALAR", 1, GLTF_ELEMENT_ARRAY_BUFFER);
+        if (!mesh.material.empty()) {
+            auto it = find(materials.begin(), materials.end(), mesh.material);
+            primitive["material"] = it - materials.begin();
+            if (it == materials.end())
+                materials.push_back(mesh.material);
+        }
+        nlohmann::ordered_json gltfMesh = { { "name", mesh.name } };
+        if (!mesh.morphs.empty()) {
+            auto targets = nlohmann::ordered_json::array();
+            auto names = nlohmann::ordered_json::array();
+            // targets store offsets from the base mesh
+            for (auto const &morph : mesh.morphs) {
+                vector<float> positions(morph.positions.size());
+                for (size_t i = 0; i < positions.size(); i++)
+                    positions[i] = morph.positions[i] - mesh.positions[i];
+                nlohmann::ordered_json target = { { "POSITION", glb.AddPositions(glb.Keep(std::move(positions))) } };
+                if (!morph.normals.empty() && morph.normals.size() == mesh.normals.size()) {
+                    vector<float> normals(morph.normals.size());
+                    for (size_t i = 0; i < normals.size(); i++)
+                        normals[i] = morph.normals[i] - mesh.normals[i];
+                    target["NORMAL"] = glb.AddAccessor(glb.Keep(std::move(normals)), GLTF_FLOAT, "VEC3", 3, GLTF_ARRAY_BUFFER);
+                }
+                targets.push_back(target);
+                names.push_back(morph.name);
+            }
+            primitive["targets"] = targets;
+            gltfMesh["weights"] = vector<float>(mesh.morphs.size(), 0.0f);
+            gltfMesh["extras"] = { { "targetNames", names } };
+        }
+        gltfMesh["primitives"] = { primitive };
+        meshes.push_back(gltfMesh);
+        nlohmann::ordered_json node = { { "name", mesh.name }, { "mesh", meshes.size() - 1 } };
+        if (skinned)
+            node["skin"] = skin;
+        roots.push_back(nodes.size());
+        nodes.push_back(node);
+    }
+    if (!meshes.empty())
+        json["meshes"] = meshes;
+    if (!materials.empty()) {
+        json["materials"] = nlohmann::ordered_json::array();
+        for (auto const &material : materials)
+            json["materials"].push_back({ { "name", material } });
+    }
+    json["nodes"] = nodes;
+    json["scene"] = 0;
+    json["scenes"] = { { { "nodes", roots } } };
+    // empty arrays and zero-length buffers are not valid glTF
+    if (glb.mBinSize)
+        json["buffers"] = { { { "byteLength", glb.mBinSize } } };
+    else {
+        json.erase("bufferViews");
+        json.erase("accessors");
+    }
+
+    string jsonText = json.dump();
+    jsonText.append((4 - jsonText.size() % 4) % 4, ' ');
+    uint32_t binSize = uint32_t((glb.mBinSize + 3) & ~size_t(3));
+    uint32_t header[5] = { 0x46546C67 /* glTF */, 2, uint32_t(12 + 8 + jsonText.size() + (binSize ? 8 + binSize : 0)),
+        uint32_t(jsonText.size()), 0x4E4F534A /* JSON */ };
+    std::ofstream file(filePath, std::ios::binary);
+    if (!file)
+        return false;
+    file.write(reinterpret_cast<char const *>(header), sizeof(header));
+    file.write(jsonText.data(), jsonText.size());
+    if (binSize) {
+        uint32_t binHeader[2] = { binSize, 0x004E4942 /* BIN */ };
+        file.write(reinterpret_cast<char const *>(binHeader), sizeof(binHeader));
+        for (auto const &[data, size] : glb.mPieces)
+            file.write(static_cast<char const *>(data), size);
+        char const zeros[4] = {};
+        file.write(zeros, binSize - glb.mBinSize);
+    }
+    return file.good();
+}
@@ -0,0 +1,119 @@
+#include "hash.h"
+#include <cstring>
+
+static constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+static constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+static constexpr uint64_t PRIME3 = 0x165667B19E3779F9ull;
+static constexpr uint64_t PRIME4 = 0x85EBCA77C2B2AE63ull;
+static constexpr uint64_t PRIME5 = 0x27D4EB2F165667C5ull;
+
+static inline uint64_t Rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t Read64(uint8_t const *p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static inline uint32_t Read32(uint8_t const *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline uint64_t Round(uint64_t acc, uint64_t input) {
+    acc += input * PRIME2;
+    acc = Rotl(acc, 31);
+    return acc * PRIME1;
+}
+
+static inline uint64_t MergeRound(uint64_t acc, uint64_t val) {
+    acc ^= Round(0, val);
+    return acc * PRIME1 + PRIME4;
+}
+
+static uint64_t Finalize(uint64_t h, uint8_t const *p, size_t len) {
+    while (len >= 8) {
+        h ^= Round(0, Read64(p));
+        h = Rotl(h, 27) * PRIME1 + PRIME4;
+        p += 8;
+        len -= 8;
+    }
+    if (len >= 4) {
+        h ^= uint64_t(Read32(p)) * PRIME1;
+        h = Rotl(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+        len -= 4;
+    }
+    while (len > 0) {
+        h ^= (*p) * PRIME5;
+        h = Rotl(h, 11) * PRIME1;
+        p++;
+        len--;
+    }
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t Hash64(void const *data, size_t size, uint64_t seed) {
+    Hasher64 hasher(seed);
+    hasher.Update(data, size);
+    return hasher.Digest();
+}
+
+Hasher64::Hasher64(uint64_t seed) : mSeed(seed) {
+    mState[0] = seed + PRIME1 + PRIME2;
+    mState[1] = seed + PRIME2;
+    mState[2] = seed;
+    mState[3] = seed - PRIME1;
+}
+
+void Hasher64::Update(void const *data, size_t size) {
+    auto p = static_cast<uint8_t const *>(data);
+    mTotalSize += size;
+    if (mBufferSize + size < 32) {
+        memcpy(mBuffer + mBufferSize, p, size);
+        mBufferSize += size;
+        return;
+    }
+    if (mBufferSize > 0) {
+        size_t fill = 32 - mBufferSize;
+        memcpy(mBuffer + mBufferSize, p, fill);
+        for (int i = 0; i < 4; i++)
+            mState[i] = Round(mState[i], Read64(mBuffer + i * 8));
+        p += fill;
+        size -= fill;
+        mBufferSize = 0;
+    }
+    while (size >= 32) {
+        mState[0] = Round(mState[0], Read64(p));
+        mState[1] = Round(mState[1], Read64(p + 8));
+        mState[2] = Round(mState[2], Read64(p + 16));
+        mState[3] = Round(mState[3], Read64(p + 24));
+        p += 32;
+        size -= 32;
+    }
+    if (size > 0) {
+        memcpy(mBuffer, p, size);
+        mBufferSize = size;
+    }
+}
+
+uint64_t Hasher64::Digest() const {
+    uint64_t h;
+    if (mTotalSize >= 32) {
+        h = Rotl(mState[0], 1) + Rotl(mState[1], 7) + Rotl(mState[2], 12) + Rotl(mState[3], 18);
+        for (int i = 0; i < 4; i++)
+            h = MergeRound(h, mState[i]);
+    }
+    else
+        h = mSeed + PRIME5;
+    h += mTotalSize;
+    return Finalize(h, mBuffer, mBufferSize);
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// xxHash64
+uint64_t Hash64(void const *data, size_t size, uint64_t seed = 0);
+
+class Hasher64 {
+    uint64_t mState[4];
+    uint8_t mBuffer[32];
+    size_t mBufferSize = 0;
+    uint64_t mTotalSize = 0;
+    uint64_t mSeed;
+public:
+    Hasher64(uint64_t seed = 0);
+    void Update(void const *data, size_t size);
+    template<typename T> void UpdateValue(T const &value) { Update(&value, sizeof(T)); }
+    uint64_t Digest() const;
+};
@@ -12,9 +12,34 @@
 #include <shobjidl.h>
 #include "nlohmann/json.hpp"
 #include "ProgressBar.h"
+#include "texdedup.h"
+#include "textures.h"
+#include "atlas.h"
+#include "texprep.h"
+#include "tempfolder.h"
+#include "convert.h"
+#include "endianflip.h"
+#include "rx3patch.h"
+#include "exportfilter.h"
+#include "rx3info.h"
+#include "catalog.h"
+#include "verify.h"
+#include "rx3diff.h"
+#include "reproducible.h"
+#include "buildcache.h"
+#include "scenecache.h"
+#include "gltf.h"
+#include "objfile.h"
+#include "fbxwriter.h"
+#include <algorithm>
 #include <fstream>
+#include <iostream>
+#include <execution>
+#include <numeric>
+#include <functional>
+#include <optional>
 
-#define RX3C_VERSION "0.200"
+#define RX3C_VERSION "0.201"
 
 using namespace rx3utils;
 
@@ -35,7 +60,15 @@ enum ErrorType {
 enum OperationType {
     OP_NONE = 0,
     OP_EXPORT = 1,
-    OP_IMPORT = 2
+    OP_IMPORT = 2,
+    OP_ATLAS = 3,
+    OP_CONVERT = 4,
+    OP_FLIP_ENDIAN = 5,
+    OP_INFO = 6,
+    OP_CATALOG = 7,
+    OP_QUERY = 8,
+    OP_VERIFY = 9,
+    OP_DIFF = 10
 };
 
 bool test() {
@@ -49,10 +82,14 @@ int wmain(int argc, wchar_t *argv[]) {
     CommandLine cmd(argc, argv,
         // arguments
         { L"i", L"o", L"game", L"skeleton", L"model", L"texture", L"folderOption", L"texFormatFile", L"baseModel",
-          L"boneMatrices", L"boneRemap", L"scale", L"move", L"poseFrom", L"poseTo" },
+          L"boneMatrices", L"boneRemap", L"scale", L"move", L"poseFrom", L"poseTo", L"preview", L"atlasSize", L"maxTextureSize",
+          L"sourceGame", L"patch", L"only", L"name",
+          L"catalogFile", L"format", L"minTextureSize", L"cache", L"modelCache" },
         // options
-        { L"export", L"import", L"recursive", L"silent", L"console", L"exportQuads", L"writeHDR", L"writeTexMetadata",
-          L"noMetadata", L"binormals", L"tristrip" }
+        { L"export", L"import", L"atlas", L"convert", L"flipEndian", L"info", L"catalog", L"query", L"verify", L"recursive", L"silent", L"console", L"exportQuads", L"writeHDR", L"writeTexMetadata",
+          L"noMetadata", L"binormals", L"tristrip", L"dedup", L"autoTexFormat", L"reproducible", L"fastObj" },
+        // multi-value arguments
+        { L"diff" }
     );
     if (cmd.HasOption(L"silent"))
         SetErrorDisplayType(ErrorDisplayType::ERR_NONE);
@@ -67,6 +104,22 @@ int wmain(int argc, wchar_t *argv[]) {
         operation = OperationType::OP_EXPORT;
     else if (cmd.HasOption(L"import"))
         operation = OperationType::OP_IMPORT;
+    else if (cmd.HasOption(L"atlas"))
+        operation = OperationType::OP_ATLAS;
+    else if (cmd.HasOption(L"convert"))
+        operation = OperationType::OP_CONVERT;
+    else if (cmd.HasOption(L"flipEndian"))
+        operation = OperationType::OP_FLIP_ENDIAN;
+    else if (cmd.HasOption(L"info"))
+        operation = OperationType::OP_INFO;
+    else if (cmd.HasOption(L"catalog"))
+        operation = OperationType::OP_CATALOG;
+    else if (cmd.HasOption(L"query"))
+        operation = OperationType::OP_QUERY;
+    else if (cmd.HasOption(L"verify"))
+        operation = OperationType::OP_VERIFY;
+    else if (cmd.HasArgument(L"diff"))
+        operation = OperationType::OP_DIFF;
     if (operation == OperationType::OP_NONE)
         return ErrorType::UNKNOWN_OPERATION_TYPE;
     path inputFolder;
@@ -132,19 +185,58 @@ int wmain(int argc, wchar_t *argv[]) {
     rx3options.tools = "RX3 Converter (rx3c), part of Rx3Tools";
     rx3options.toolsVersion = RX3C_VERSION;
     rx3options.cmdLine = ToUTF8(GetCommandLineW());
+    bool reproducible = cmd.HasOption(L"reproducible");
+    std::time_t runStart = std::time(nullptr);
+    if (reproducible)
+        rx3options.cmdLine = ReproducibleCommandLine(argc, argv);
 
-    if (cmd.HasArgument(L"game"))
-        rx3options.game = ToLower(WtoA(cmd.GetArgumentString(L"game")));
-    if (!GameConfigs().contains(rx3options.game)) {
-        ErrorMessage("Unknown game");
-        return ErrorType::UNKNOWN_GAME_TAG;
+    // -game, -model and -texture accept lists, comma-separated or repeated
+    auto GetArgumentList = [&](wstring const &argument) {
+        vector<string> values;
+        for (auto const &value : cmd.GetArgumentStrings(argument)) {
+            for (auto const &part : Split(value, ',')) {
+                string item = ToLower(WtoA(part));
+                if (!item.empty() && find(values.begin(), values.end(), item) == values.end())
+                    values.push_back(item);
+            }
+        }
+        return values;
+    };
+
+    // import and convert write one set of rx3 files per game (into a subfolder per game when there are several)
+    vector<string> games = GetArgumentList(L"game");
+    if (games.empty())
+        games.push_back(rx3options.game);
+    for (auto const &game : games) {
+        if (!GameConfigs().contains(game)) {
+            ErrorMessage("Unknown game");
+            return ErrorType::UNKNOWN_GAME_TAG;
+        }
     }
-    rx3options.gameConfig = GameConfigs()[rx3options.game];
+    auto SelectGame = [&](string const &game) {
+        rx3options.game = game;
+        rx3options.gameConfig = GameConfigs()[game];
+    };
+    SelectGame(games.front());
+    auto GameFolder = [&](path const &outFolder, string const &game) {
+        if (games.size() == 1)
+            return outFolder;
+        path gameFolder = outFolder / AtoW(game);
+        create_directories(gameFolder);
+        return gameFolder;
+    };
 
-    if (cmd.HasArgument(L"model"))
-        rx3options.modelFormat = ToLower(WtoA(cmd.GetArgumentString(L"model")));
-    if (cmd.HasArgument(L"texture"))
-        rx3options.textureFormat = ToLower(WtoA(cmd.GetArgumentString(L"texture")));
+    // export writes all listed formats, import uses the first one as the preferred source format
+    vector<string> modelFormats = GetArgumentList(L"model");
+    vector<string> textureFormats = GetArgumentList(L"texture");
+    if (!modelFormats.empty())
+        rx3options.modelFormat = modelFormats.front();
+    else
+        modelFormats.push_back(rx3options.modelFormat);
+    if (!textureFormats.empty())
+        rx3options.textureFormat = textureFormats.front();
+    else
+        textureFormats.push_back(rx3options.textureFormat);
     if (cmd.HasArgument(L"folderOption")) {
         auto strFolderOption = ToLower(cmd.GetArgumentString(L"folderOption"));
         if (strFolderOption == L"alwayscreate")
@@ -156,10 +248,15 @@ int wmain(int argc, wchar_t *argv[]) {
     rx3options.exportQuads = cmd.HasOption(L"exportQuads");
     rx3options.writeHDR = cmd.HasOption(L"writeHDR");
     rx3options.writeTexMetadata = cmd.HasOption(L"writeTexMetadata");
+    vector<string> texFormatOrder;
+    TexturePrepSettings texPrep;
+    texPrep.maxSize = max(cmd.GetArgumentInt(L"maxTextureSize", 0), 0);
     if (cmd.HasArgument(L"texFormatFile")) {
-        vector<string> order;
-        ReadTexFormatFile(cmd.GetArgumentPath(L"texFormatFile"), rx3options.texTargetFormats, order);
+        ReadTexFormatFile(cmd.GetArgumentPath(L"texFormatFile"), rx3options.texTargetFormats, texFormatOrder);
+        texPrep.ReadRules(cmd.GetArgumentPath(L"texFormatFile"));
     }
+    texPrep.autoFormat = cmd.HasOption(L"autoTexFormat");
+    texPrep.formatPatterns = texFormatOrder;
     rx3options.metadata = !cmd.HasOption(L"noMetadata");
     rx3options.binormals = cmd.HasOption(L"binormals");
     rx3options.tristrip = cmd.HasOption(L"tristrip");
@@ -217,20 +314,199 @@ int wmain(int argc, wchar_t *argv[]) {
             rx3options.baseModel = ReadModelFromRX3(baseModelPath, rx3options);
     }
 
-    auto ExportRX3 = [&](path const &in, path const &outFolder) {
+    bool dedup = cmd.HasOption(L"dedup");
+    TextureDedup textureDedup;
+    uint32_t previewSize = max(cmd.GetArgumentInt(L"preview", 0), 0);
+    path patchTarget = cmd.GetArgumentPath(L"patch");
+    // the patched file has one byte order and one output path
+    if (!patchTarget.empty() && games.size() > 1) {
+        ErrorMessage("-patch can't be combined with several -game values");
+        return ErrorType::ERROR_OTHER;
+    }
+    ExportFilter exportFilter;
+    if (!exportFilter.Parse(GetArgumentList(L"only"), GetArgumentList(L"name"))) {
+        ErrorMessage("Unknown -only value (expected textures, model or hotspot)");
+        return ErrorType::ERROR_OTHER;
+    }
+    TempFolder filteredFiles;
+    BuildCache buildCache(cmd.GetArgumentPath(L"cache"), RX3C_VERSION, cmd,
+        { L"i", L"o", L"cache", L"modelCache", L"silent", L"console", L"recursive" });
+    // parsed source models are kept by content hash, so option-only changes skip the FBX/OBJ load
+    path modelCacheFolder = cmd.GetArgumentPath(L"modelCache");
+    if (modelCacheFolder.empty() && buildCache.IsEnabled())
+        modelCacheFolder = cmd.GetArgumentPath(L"cache") / L"models";
+    uint64_t modelCacheKey = modelCacheFolder.empty() ? 0 : BuildKey(RX3C_VERSION);
+    // rx3c's OBJ reader is faster but doesn't match ModelLibrary on every file (texture v, materials, normals)
+    bool fastObj = cmd.HasOption(L"fastObj");
+    // false (and nothing to convert) if the source can't be read
+    auto ReadSourceModel = [&](path const &modelPath, Model &model) {
+        // glTF (and OBJ with -fastObj) are read by rx3c directly from the mapped file, which is about as fast as the
+        // cache; OBJ files rx3c can't parse go through ModelLibrary
+        wstring ext = ToLower(modelPath.extension().wstring());
+        if (ext == L".glb" || ext == L".gltf") {
+            Scene scene;
+            if (!ReadGltf(modelPath, scene) || !SceneToModel(scene, model))
+                return ErrorMessage("Failed to read " + ToUTF8(modelPath.c_str()));
+            return true;
+        }
+        if (ext == L".obj" && fastObj) {
+            Scene scene;
+            if (!ReadObj(modelPath, scene) || !SceneToModel(scene, model))
+                model = ReadModelFromFile(modelPath);
+            return true;
+        }
+        path cachePath = modelCacheFolder.empty() ? path() : SceneCachePath(modelCacheFolder, modelPath, modelCacheKey);
+        Scene scene;
+        if (!cachePath.empty() && LoadSceneFile(cachePath, scene) && SceneToModel(scene, model))
+            return true;
+        model = ReadModelFromFile(modelPath);
+        if (!cachePath.empty() && ModelToScene(model, scene)) {
+            std::error_code ec;
+            create_directories(modelCacheFolder, ec);
+            SaveSceneFile(scene, cachePath);
+            // a miss converts the same Scene a later hit loads, so both give the same rx3
+            Model cached;
+            if (SceneToModel(scene, cached))
+                model = std::move(cached);
+        }
+        return true;
+    };
+    auto FinishRx3 = [&](path const &rx3Path) {
+        if (reproducible && exists(rx3Path))
+            NormalizeRx3File(rx3Path, runStart);
+    };
+
+    auto ExportRX3 = [&](path const &source, path const &outFolder) {
+        path in = source;
+        if (previewSize > 0 || exportFilter.IsActive()) {
+            // chunks are selected on the mapped file, unselected ones are never copied or decoded; rx3c decodes the
+            // selected textures from the mapped file, rx3lib gets an rx3 holding only the selected chunks
+            Rx3File raw;
+            if (!raw.Open(source)) {
+                if (previewSize > 0)
+                    ErrorMessage("No preview for " + ToUTF8(source.c_str()) + ": not a valid rx3 file");
+                return false;
+            }
+            vector<Rx3FileChunk const *> selected;
+            if (exportFilter.IsActive()) {
+                selected = SelectExportChunks(raw, exportFilter);
+                if (selected.empty())
+                    return true;
+            }
+            else {
+                for (auto const &c : raw.Chunks())
+                    selected.push_back(&c);
+            }
+            vector<Rx3FileChunk const *> textures;
+            bool hasBatch = false, texturesOnly = true;
+            for (auto const *c : selected) {
+                if (c->type == RX3_CHUNK_TEXTURE)
+                    textures.push_back(c);
+                else if (c->type == RX3_CHUNK_TEXTURE_BATCH)
+                    hasBatch = true;
+                else if (c->type != RX3_CHUNK_NAMES)
+                    texturesOnly = false;
+            }
+            bool createFolder = rx3options.folderOption == FOLDER_OPTION_ALWAYS_CREATE ||
+                (rx3options.folderOption == FOLDER_OPTION_AUTO && hasBatch);
+            path outDir = createFolder ? (outFolder / source.stem()) : outFolder;
+            if (previewSize > 0) {
+                // textures only, decoded from the smallest mip level that fits into previewSize
+                // rx3lib can only write full-size images, so files rx3c can't decode are reported and skipped
+                if (!textures.empty() && !ExtractDecodedTexturesFromRX3(raw, textures, outDir, previewSize, textureFormats))
+                    return ErrorMessage("No preview for " + ToUTF8(source.c_str()) + ": texture format or layout not supported by the preview decoder");
+                return true;
+            }
+            // selected textures rx3c can decode need no container, unless rx3lib has to write metadata or dedup links
+            if (texturesOnly && !rx3options.writeTexMetadata && !dedup &&
+                ExtractDecodedTexturesFromRX3(raw, textures, outDir, 0, textureFormats))
+            {
+                return true;
+            }
+            in = filteredFiles.Path() / source.filename();
+            if (!SaveSelectedChunks(raw, selected, in))
+                return false;
+        }
+        // false if any output failed, so that -cache doesn't store a partial export
+        bool succeeded = true;
         Rx3Container rx3(in);
         bool createFolder = rx3options.folderOption == FOLDER_OPTION_ALWAYS_CREATE ||
             (rx3options.folderOption == FOLDER_OPTION_AUTO && rx3.FindFirstChunk(RX3_CHUNK_TEXTURE_BATCH));
         path outDir = createFolder ? (outFolder / rx3.mName) : outFolder;
-        if (rx3.FindFirstChunk(RX3_CHUNK_TEXTURE))
-            ExtractTexturesFromRX3(rx3, outDir, rx3options);
+        if (rx3.FindFirstChunk(RX3_CHUNK_TEXTURE)) {
+            // the first format goes through rx3lib (or the dedup cache), every other format and QOI are
+            // written by rx3c from a single decode of each texture
+            vector<string> decodedFormats;
+            for (size_t i = 0; i < textureFormats.size(); i++) {
+                if (i != 0 || textureFormats[i] == "qoi")
+                    decodedFormats.push_back(textureFormats[i]);
+            }
+            if (textureFormats.front() != "qoi") {
+                // exported files are linked across jobs, which cached jobs (separate temp folders) can't do
+                if (dedup && !buildCache.IsEnabled())
+                    textureDedup.ExtractTextures(rx3, in, outDir, rx3options);
+                else
+                    ExtractTexturesFromRX3(rx3, outDir, rx3options);
+            }
+            if (!decodedFormats.empty()) {
+                Rx3File raw;
+                if (!raw.Open(in) || !ExtractDecodedTexturesFromRX3(raw, outDir, 0, decodedFormats)) {
+                    // textures rx3c cannot decode are exported by rx3lib, QOI falls back to DDS
+                    string firstFormat = rx3options.textureFormat;
+                    for (auto const &format : decodedFormats) {
+                        rx3options.textureFormat = format == "qoi" ? "dds" : format;
+                        ExtractTexturesFromRX3(rx3, outDir, rx3options);
+                    }
+                    rx3options.textureFormat = firstFormat;
+                }
+            }
+        }
         if (rx3.FindFirstChunk(RX3_CHUNK_HOTSPOT))
             ExtractHotspotFromRX3(rx3, outDir, rx3options);
-        if (rx3.FindFirstChunk(RX3_CHUNK_VERTEX_BUFFER))
-            ExtractModelFromRX3(rx3, outDir, rx3options);
+        if (rx3.FindFirstChunk(RX3_CHUNK_VERTEX_BUFFER)) {
+            string firstFormat = rx3options.modelFormat;
+            // formats written by rx3c share one read of the model
+            std::optional<Scene> scene;
+            bool sceneRead = false;
+            for (auto const &format : modelFormats) {
+                // rx3c writes triangles only, quads come from rx3lib
+                if (format == "glb" || (format == "obj" && !rx3options.exportQuads) || format == "fbxfast") {
+                    if (!scene) {
+                        scene.emplace();
+                        sceneRead = ModelToScene(ReadModelFromRX3(in, rx3options), *scene);
+                        if (!sceneRead)
+                            succeeded = ErrorMessage("Failed to read model from " + ToUTF8(in.c_str()));
+                    }
+                    // rx3lib's .mtl references the exported textures, the rx3c writer's doesn't
+                    bool objMaterials = format == "obj" && sceneRead &&
+                        std::ranges::any_of(scene->meshes, [](SceneMesh const &mesh) { return !mesh.material.empty(); });
+                    if (sceneRead && !objMaterials) {
+                        std::error_code ec;
+                        create_directories(outDir, ec);
+                        path modelPath = outDir / rx3.mName;
+                        modelPath += format == "fbxfast" ? L".fbx" : (L"." + AtoW(format));
+                        bool written = format == "glb" ? WriteGlb(*scene, modelPath) :
+                            (format == "obj" ? WriteObj(*scene, modelPath) : WriteFbx(*scene, modelPath));
+                        if (!written)
+                            succeeded = ErrorMessage("Failed to write " + ToUTF8(modelPath.c_str()));
+                        continue;
+                    }
+                    if (format == "glb") {
+                        succeeded = ErrorMessage("Unable to write glb for " + ToUTF8(in.c_str()));
+                        continue;
+                    }
+                }
+                // fbxfast falls back to the FBX SDK
+                rx3options.modelFormat = format == "fbxfast" ? "fbx" : format;
+                ExtractModelFromRX3(rx3, outDir, rx3options);
+            }
+            rx3options.modelFormat = firstFormat;
+        }
+        return succeeded;
     };
 
     auto ImportRX3 = [&](vector<path> const &inFiles, wstring const &rx3DefaultName, path const &outFolder) {
+        bool succeeded = true;
         vector<path> inTextures;
         vector<path> inModels;
         path inHotspot, inMetadata;
@@ -239,7 +515,7 @@ int wmain(int argc, wchar_t *argv[]) {
         vector<path> tempHotspots, tempMetadata;
         for (auto const &file : inFiles) {
             wstring ext = ToLower(file.extension().wstring());
-            if (ext == L".fbx" || ext == L".obj") {
+            if (ext == L".fbx" || ext == L".obj" || ext == L".glb" || ext == L".gltf") {
                 path groupKey = file.parent_path() / ToLower(file.stem().wstring());
                 modelGroups[groupKey.wstring()].push_back(file);
             }
@@ -247,7 +523,7 @@ int wmain(int argc, wchar_t *argv[]) {
                 tempHotspots.push_back(file);
             else if (ext == L".csv")
                 tempMetadata.push_back(file);
-            else if (ext == L".dds" || ext == L".png" || ext == L".tga" || ext == L".hdr") {
+            else if (ext == L".dds" || ext == L".png" || ext == L".tga" || ext == L".hdr" || ext == L".qoi") {
                 path groupKey = file.parent_path() / ToLower(file.stem().wstring());
                 textureGroups[groupKey.wstring()].push_back(file);
             }
@@ -271,7 +547,7 @@ int wmain(int argc, wchar_t *argv[]) {
                 }
             }
         }
-        vector<wstring> texExtPriority = { L".dds", L".hdr", L".png", L".tga" };
+        vector<wstring> texExtPriority = { L".dds", L".hdr", L".png", L".tga", L".qoi" };
         if (!rx3options.textureFormat.empty()) {
             wstring prefExt = L"." + AtoW(rx3options.textureFormat);
             prefExt = ToLower(prefExt);
@@ -298,11 +574,11 @@ int wmain(int argc, wchar_t *argv[]) {
                 inTextures.push_back(bestFile);
             }
         }
-        vector<wstring> modelExtPriority = { L".fbx", L".obj" };
+        vector<wstring> modelExtPriority = { L".fbx", L".obj", L".glb", L".gltf" };
         if (!rx3options.modelFormat.empty()) {
             wstring prefExt = L"." + AtoW(rx3options.modelFormat);
             prefExt = ToLower(prefExt);
-            if (prefExt == L".fbxascii")
+            if (prefExt == L".fbxascii" || prefExt == L".fbxfast")
                 prefExt = L".fbx";
             auto it = find(modelExtPriority.begin(), modelExtPriority.end(), prefExt);
             if (it != modelExtPriority.end())
@@ -335,47 +611,144 @@ int wmain(int argc, wchar_t *argv[]) {
             }
         }
         if (!inTextures.empty()) {
-            Rx3Container rx3(rx3options.gameConfig.BigEndian);
-            rx3.AddChunk(RX3_CHUNK_TEXTURE_BATCH);
-            ImportTexturesToRX3(rx3, inTextures, inMetadata, rx3options);
-            if (!inHotspot.empty())
-                ImportHotspotToRX3(rx3, inHotspot, rx3options);
+            // source textures are prepared once, encoding and serialization run per game
+            TempFolder preparedTextures;
+            vector<TextureFormatDecision> formatDecisions;
+            vector<path> importTextures = PrepareTexturesForImport(inTextures, texPrep, preparedTextures.Path(), &formatDecisions);
             wstring textureFileName = rx3DefaultName;
             if (hasNameCollision)
                 textureFileName += L"_textures";
-            path rx3path = outFolder / (textureFileName + L".rx3");
-            if (rx3options.metadata) {
-                string sourceFiles = ToUTF8(inTextures[0].c_str());
+            string sourceFiles;
+            if (rx3options.metadata && reproducible)
+                sourceFiles = ReproducibleSourceList(inTextures, isFolder ? inputFolder : path());
+            else if (rx3options.metadata) {
+                sourceFiles = ToUTF8(inTextures[0].c_str());
                 for (size_t ti = 1; ti < inTextures.size(); ti++)
                     sourceFiles += ";" + ToUTF8(inTextures[ti].c_str());
-                AddMetadataToRx3(rx3, sourceFiles, rx3path, rx3options.cmdLine);
             }
-            rx3.Save(rx3path);
+            if (!patchTarget.empty()) {
+                // only the imported textures (and hotspot) are encoded, the rest of the target is copied as is
+                Rx3Container rx3(rx3options.gameConfig.BigEndian);
+                rx3.AddChunk(RX3_CHUNK_TEXTURE_BATCH);
+                ImportTexturesToRX3(rx3, importTextures, inMetadata, rx3options);
+                if (!inHotspot.empty())
+                    ImportHotspotToRX3(rx3, inHotspot, rx3options);
+                path patchPath = preparedTextures.Path() / L"patch.rx3";
+                rx3.Save(patchPath);
+                if (!PatchRx3(patchTarget, patchPath, outFolder / patchTarget.filename()))
+                    succeeded = ErrorMessage("Failed to patch " + ToUTF8(patchTarget.c_str()) + " (check that -game matches its byte order)");
+                else
+                    FinishRx3(outFolder / patchTarget.filename());
+            }
+            else {
+                for (auto const &game : games) {
+                    SelectGame(game);
+                    path gameFolder = GameFolder(outFolder, game);
+                    Rx3Container rx3(rx3options.gameConfig.BigEndian);
+                    rx3.AddChunk(RX3_CHUNK_TEXTURE_BATCH);
+                    TextureDedup::ImportPlan dedupPlan;
+                    if (dedup) {
+                        dedupPlan = textureDedup.PrepareImport(importTextures, texFormatOrder, game, inMetadata);
+                        if (!dedupPlan.toEncode.empty())
+                            ImportTexturesToRX3(rx3, dedupPlan.toEncode, inMetadata, rx3options);
+                    }
+                    else
+                        ImportTexturesToRX3(rx3, importTextures, inMetadata, rx3options);
+                    if (!inHotspot.empty())
+                        ImportHotspotToRX3(rx3, inHotspot, rx3options);
+                    path rx3path = gameFolder / (textureFileName + L".rx3");
+                    if (rx3options.metadata)
+                        AddMetadataToRx3(rx3, sourceFiles, reproducible ? ReproduciblePath(rx3path, outFolder) : rx3path, rx3options.cmdLine);
+                    rx3.Save(rx3path);
+                    if (dedup)
+                        textureDedup.FinishImport(rx3path, dedupPlan);
+                    FinishRx3(rx3path);
+                    if (rx3options.writeTexMetadata && !formatDecisions.empty())
+                        WriteTextureFormatDecisions(formatDecisions, inMetadata, gameFolder / (textureFileName + L"_metadata.csv"));
+                }
+                SelectGame(games.front());
+            }
         }
         if (!inModels.empty()) {
             for (auto const &inModel : inModels) {
                 wstring filename = inModel.stem().wstring();
                 wstring loweredFilename = ToLower(filename);
-                Model model = ReadModelFromFile(inModel);
-                // Skeleton
-                if (model.IsSkeleton()) {
-                    if (!rx3options.targetSkeleton.bones.empty())
-                        ModelToSkeletonContainer(model, inModel, outFolder / (filename + L".rx3"), rx3options);
+                Model model;
+                if (!ReadSourceModel(inModel, model)) {
+                    succeeded = false;
+                    continue;
                 }
-                else {
-                    // Morph
-                    if (model.HasShapeKeys() && !rx3options.baseModel.objects.empty()) {
-                        bool isMorphtargetsFilename = loweredFilename.ends_with(L"_morphtargets");
-                        wstring outMorphModelName = isMorphtargetsFilename ? (filename + L"_morphtargets") : filename;
-                        ModelToMorphTargetsContainer(model, inModel, outFolder / (outMorphModelName + L".rx3"), rx3options);
+                // the converters record this path in metadata
+                path sourcePath = reproducible ? ReproduciblePath(inModel, isFolder ? inputFolder : path()) : inModel;
+                for (size_t g = 0; g < games.size(); g++) {
+                    SelectGame(games[g]);
+                    path gameFolder = GameFolder(outFolder, games[g]);
+                    // the source model is read once; containers may adjust it for their target, so every game but the last gets a copy
+                    Model gameModel = (g + 1 < games.size()) ? model : std::move(model);
+                    path outPath = gameFolder / (filename + L".rx3");
+                    // Skeleton
+                    if (gameModel.IsSkeleton()) {
+                        if (!rx3options.targetSkeleton.bones.empty())
+                            ModelToSkeletonContainer(gameModel, sourcePath, outPath, rx3options);
                     }
-                    else if (!model.objects.empty()) {
-                        // Simple model
-                        ModelToSimpleMeshContainer(model, inModel, outFolder / (filename + L".rx3"), rx3options);
+                    else {
+                        // Morph
+                        if (gameModel.HasShapeKeys() && !rx3options.baseModel.objects.empty()) {
+                            bool isMorphtargetsFilename = loweredFilename.ends_with(L"_morphtargets");
+                            wstring outMorphModelName = isMorphtargetsFilename ? (filename + L"_morphtargets") : filename;
+                            outPath = gameFolder / (outMorphModelName + L".rx3");
+                            ModelToMorphTargetsContainer(gameModel, sourcePath, outPath, rx3options);
+                        }
+                        else if (!gameModel.objects.empty()) {
+                            // Simple model
+                            ModelToSimpleMeshContainer(gameModel, sourcePath, outPath, rx3options);
+                        }
                     }
+                    FinishRx3(outPath);
                 }
+                SelectGame(games.front());
+            }
+        }
+        return succeeded;
+    };
+
+    // with -cache every export (per rx3 file) and import (per folder) runs into a temp folder whose contents
+    // are stored in the cache and then copied to the output folder
+    auto RunCached = [&](string const &kind, wstring const &name, vector<path> inputs, path const &outFolder,
+        std::function<bool(path const &)> const &job)
+    {
+        if (!buildCache.IsEnabled()) {
+            job(outFolder);
+            return;
+        }
+        std::sort(inputs.begin(), inputs.end());
+        uint64_t key = buildCache.JobKey(kind, name, inputs);
+        if (buildCache.Restore(key, outFolder))
+            return;
+        TempFolder result;
+        // failed or empty results are not cached, the next run tries again
+        std::error_code ec;
+        if (job(result.Path()) && !std::filesystem::is_empty(result.Path(), ec) && !ec)
+            buildCache.Store(key, result.Path());
+        create_directories(outFolder, ec);
+        copy(result.Path(), outFolder, copy_options::recursive | copy_options::overwrite_existing, ec);
+    };
+
+    auto CollectRx3Files = [&]() {
+        vector<path> filesToProcess;
+        if (cmd.HasOption(L"recursive")) {
+            for (auto const &p : recursive_directory_iterator(inputFolder)) {
+                if (!is_directory(p) && ToLower(p.path().extension().wstring()) == L".rx3")
+                    filesToProcess.push_back(p.path());
             }
         }
+        else {
+            for (auto const &p : directory_iterator(inputFolder)) {
+                if (!is_directory(p) && ToLower(p.path().extension().wstring()) == L".rx3")
+                    filesToProcess.push_back(p.path());
+            }
+        }
+        return filesToProcess;
     };
 
     HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
@@ -383,28 +756,16 @@ int wmain(int argc, wchar_t *argv[]) {
         return FAILED_TO_INITIALIZE;
     if (operation == OperationType::OP_EXPORT) {
         if (isFolder) {
-            vector<path> filesToProcess;
-            if (cmd.HasOption(L"recursive")) {
-                for (auto const &p : recursive_directory_iterator(inputFolder)) {
-                    if (!is_directory(p) && ToLower(p.path().extension().wstring()) == L".rx3")
-                        filesToProcess.push_back(p.path());
-                }
-            }
-            else {
-                for (auto const &p : directory_iterator(inputFolder)) {
-                    if (!is_directory(p) && ToLower(p.path().extension().wstring()) == L".rx3")
-                        filesToProcess.push_back(p.path());
-                }
-            }
+            vector<path> filesToProcess = CollectRx3Files();
             for (auto const &p : filesToProcess) {
                 auto rel = relative(p, inputFolder).parent_path();
                 auto outSubFolder = o / rel;
-                ExportRX3(p, outSubFolder);
+                RunCached("export", p.filename().wstring(), { p }, outSubFolder, [&](path const &out) { return ExportRX3(p, out); });
             }
         }
         else {
             for (auto const &f : inputFiles)
-                ExportRX3(f, o);
+                RunCached("export", f.filename().wstring(), { f }, o, [&](path const &out) { return ExportRX3(f, out); });
         }
     }
     else if (operation == OperationType::OP_IMPORT) {
@@ -416,7 +777,7 @@ int wmain(int argc, wchar_t *argv[]) {
                         filesByDirectory[p.path().parent_path()].push_back(p.path());
                 }
                 for (auto const &[dirPath, files] : filesByDirectory)
-                    ImportRX3(files, dirPath.stem().wstring(), o);
+                    RunCached("import", dirPath.stem().wstring(), files, o, [&](path const &out) { return ImportRX3(files, dirPath.stem().wstring(), out); });
             }
             else {
                 vector<path> filesToProcess;
@@ -425,17 +786,217 @@ int wmain(int argc, wchar_t *argv[]) {
                         filesToProcess.push_back(p.path());
                 }
                 if (!filesToProcess.empty())
-                    ImportRX3(filesToProcess, inputFolder.stem().wstring(), o);
+                    RunCached("import", inputFolder.stem().wstring(), filesToProcess, o, [&](path const &out) {
+                        return ImportRX3(filesToProcess, inputFolder.stem().wstring(), out);
+                    });
             }
         }
         else {
             if (!inputFiles.empty()) {
-                wstring defaultName = L"unnamed";
-                if (inputFiles[0].has_parent_path())
-                    defaultName = inputFiles[0].parent_path().wstring();
-                ImportRX3(inputFiles, defaultName, o);
+                // named after the folder of the first file, like folder imports; a full path would escape the output
+                // (and cache) folder and make the cache key depend on where the inputs are
+                wstring defaultName = inputFiles[0].parent_path().filename().wstring();
+                if (defaultName.empty())
+                    defaultName = L"unnamed";
+                RunCached("import", defaultName, inputFiles, o, [&](path const &out) { return ImportRX3(inputFiles, defaultName, out); });
+            }
+        }
+    }
+    else if (operation == OperationType::OP_ATLAS) {
+        uint32_t thumbnailSize = previewSize > 0 ? previewSize : 128;
+        uint32_t atlasSize = max(cmd.GetArgumentInt(L"atlasSize", 4096), 0);
+        vector<path> filesToProcess = isFolder ? CollectRx3Files() : inputFiles;
+        if (!GenerateTextureAtlas(filesToProcess, isFolder ? inputFolder : path(), o, thumbnailSize, atlasSize)) {
+            ErrorMessage("Failed to generate texture atlas");
+            CoUninitialize();
+            return ErrorType::ERROR_OTHER;
+        }
+    }
+    else if (operation == OperationType::OP_CONVERT) {
+        string sourceGame = ToLower(WtoA(cmd.GetArgumentString(L"sourceGame")));
+        if (!GameConfigs().contains(sourceGame)) {
+            ErrorMessage("Unknown source game");
+            CoUninitialize();
+            return ErrorType::UNKNOWN_GAME_TAG;
+        }
+        Rx3Options sourceOptions = rx3options;
+        sourceOptions.game = sourceGame;
+        sourceOptions.gameConfig = GameConfigs()[sourceGame];
+        vector<path> filesToProcess = isFolder ? CollectRx3Files() : inputFiles;
+        bool failed = false;
+        // each file is read once and written for every game
+        for (auto const &p : filesToProcess) {
+            path outSubFolder = isFolder ? (o / relative(p, inputFolder).parent_path()) : o;
+            vector<Rx3ConvertTarget> targets;
+            for (auto const &game : games) {
+                SelectGame(game);
+                targets.push_back({ GameFolder(outSubFolder, game) / p.filename(), rx3options });
+            }
+            if (!ConvertRx3(p, reproducible ? ReproduciblePath(p, isFolder ? inputFolder : path()) : p, targets, sourceOptions))
+                failed = true;
+            else {
+                for (auto const &t : targets)
+                    FinishRx3(t.out);
+            }
+        }
+        SelectGame(games.front());
+        if (failed) {
+            CoUninitialize();
+            return ErrorType::ERROR_OTHER;
+        }
+    }
+    else if (operation == OperationType::OP_FLIP_ENDIAN) {
+        vector<path> filesToProcess = isFolder ? CollectRx3Files() : inputFiles;
+        bool failed = false;
+        for (auto const &p : filesToProcess) {
+            path outSubFolder = isFolder ? (o / relative(p, inputFolder).parent_path()) : o;
+            set<uint32_t> unknownTypes, unflippedTypes;
+            if (!FlipRx3Endianness(p, outSubFolder / p.filename(), unknownTypes, unflippedTypes)) {
+                string msg = "Failed to flip byte order of " + ToUTF8(p.c_str());
+                if (!unknownTypes.empty()) {
+                    msg += ", chunk types that can't be flipped:";
+                    for (auto type : unknownTypes)
+                        msg += " " + to_string(type);
+                    msg += " (use -convert instead)";
+                }
+                ErrorMessage(msg);
+                failed = true;
+            }
+            else if (!unflippedTypes.empty()) {
+                string msg = ToUTF8(p.c_str()) + ": chunks copied without flipping:";
+                for (auto type : unflippedTypes)
+                    msg += " " + Rx3ChunkTypeName(type);
+                ErrorMessage(msg);
+            }
+        }
+        if (failed) {
+            CoUninitialize();
+            return ErrorType::ERROR_OTHER;
+        }
+    }
+    else if (operation == OperationType::OP_INFO) {
+        // one JSON line per file, in input order
+        vector<path> filesToProcess = isFolder ? CollectRx3Files() : inputFiles;
+        vector<string> lines(filesToProcess.size());
+        vector<size_t> indices(filesToProcess.size());
+        std::iota(indices.begin(), indices.end(), 0);
+        std::for_each(std::execution::par, indices.begin(), indices.end(), [&](size_t i) {
+            nlohmann::ordered_json info;
+            info["file"] = ToUTF8(filesToProcess[i].c_str());
+            Rx3File rx3;
+            if (rx3.Open(filesToProcess[i]))
+                info.update(ReadRx3Info(rx3));
+            else
+                info["error"] = "not a valid rx3 file";
+            lines[i] = info.dump();
+        });
+        for (auto const &line : lines)
+            std::cout << line << '\n';
+        std::cout.flush();
+    }
+    else if (operation == OperationType::OP_CATALOG || operation == OperationType::OP_QUERY) {
+        // -catalog refreshes the catalog of the input files, -query only reads it; both answer texture queries
+        path catalogPath = cmd.GetArgumentPath(L"catalogFile", o / L"rx3c.catalog");
+        if (operation == OperationType::OP_CATALOG) {
+            vector<path> failedFiles;
+            if (!UpdateRx3Catalog(catalogPath, isFolder ? inputFolder : current_path(), isFolder ? CollectRx3Files() : inputFiles, failedFiles)) {
+                ErrorMessage("Failed to write catalog");
+                CoUninitialize();
+                return ErrorType::ERROR_OTHER;
+            }
+            for (auto const &f : failedFiles)
+                ErrorMessage("Failed to read " + ToUTF8(f.c_str()) + ", not added to the catalog");
+        }
+        Rx3CatalogQuery query;
+        query.textureNames = exportFilter.names;
+        query.formats = GetArgumentList(L"format");
+        query.minTextureSize = max(cmd.GetArgumentInt(L"minTextureSize", 0), 0);
+        if (operation == OperationType::OP_QUERY || !query.textureNames.empty() || !query.formats.empty() || query.minTextureSize != 0) {
+            Rx3Catalog catalog;
+            if (!catalog.Open(catalogPath)) {
+                ErrorMessage("Failed to read catalog");
+                CoUninitialize();
+                return ErrorType::ERROR_OTHER;
+            }
+            for (auto const &line : QueryRx3Catalog(catalog, query))
+                std::cout << line << '\n';
+            std::cout.flush();
+        }
+    }
+    else if (operation == OperationType::OP_VERIFY) {
+        // failures only, one JSON line per file in input order
+        vector<path> filesToProcess = isFolder ? CollectRx3Files() : inputFiles;
+        vector<vector<string>> errors(filesToProcess.size());
+        vector<size_t> indices(filesToProcess.size());
+        std::iota(indices.begin(), indices.end(), 0);
+        std::for_each(std::execution::par, indices.begin(), indices.end(), [&](size_t i) {
+            errors[i] = VerifyRx3(filesToProcess[i]);
+        });
+        bool failed = false;
+        for (size_t i = 0; i < filesToProcess.size(); i++) {
+            if (errors[i].empty())
+                continue;
+            nlohmann::ordered_json report;
+            report["file"] = ToUTF8(filesToProcess[i].c_str());
+            report["errors"] = errors[i];
+            std::cout << report.dump() << '\n';
+            failed = true;
+        }
+        std::cout.flush();
+        if (failed) {
+            CoUninitialize();
+            return ErrorType::ERROR_OTHER;
+        }
+    }
+    else if (operation == OperationType::OP_DIFF) {
+        // -diff a b with two files or two folders (compared by relative path); one JSON line per difference
+        vector<path> sides = cmd.GetArgumentPaths(L"diff");
+        if (sides.size() != 2 || !exists(sides[0]) || !exists(sides[1]) || is_directory(sides[0]) != is_directory(sides[1])) {
+            ErrorMessage("-diff needs two files or two folders");
+            CoUninitialize();
+            return ErrorType::INVALID_INPUT_PATH;
+        }
+        vector<pair<path, path>> pairs;
+        if (is_directory(sides[0])) {
+            map<wstring, pair<path, path>> byName;
+            for (size_t side = 0; side < 2; side++) {
+                for (auto const &p : recursive_directory_iterator(sides[side])) {
+                    if (!is_directory(p) && ToLower(p.path().extension().wstring()) == L".rx3") {
+                        auto &entry = byName[ToLower(relative(p.path(), sides[side]).wstring())];
+                        (side == 0 ? entry.first : entry.second) = p.path();
+                    }
+                }
+            }
+            for (auto const &[name, entry] : byName)
+                pairs.push_back(entry);
+        }
+        else
+            pairs.emplace_back(sides[0], sides[1]);
+        vector<string> lines(pairs.size());
+        vector<size_t> indices(pairs.size());
+        std::iota(indices.begin(), indices.end(), 0);
+        std::for_each(std::execution::par, indices.begin(), indices.end(), [&](size_t i) {
+            auto const &[a, b] = pairs[i];
+            nlohmann::ordered_json report;
+            if (!a.empty())
+                report["a"] = ToUTF8(a.c_str());
+            if (!b.empty())
+                report["b"] = ToUTF8(b.c_str());
+            if (a.empty() || b.empty())
+                report["status"] = a.empty() ? "added" : "removed";
+            else {
+                auto diff = DiffRx3(a, b);
+                if (diff.empty())
+                    return;
+                report.update(diff);
             }
+            lines[i] = report.dump();
+        });
+        for (auto const &line : lines) {
+            if (!line.empty())
+                std::cout << line << '\n';
         }
+        std::cout.flush();
     }
     CoUninitialize();
     return ErrorType::NONE;
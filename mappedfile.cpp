@@ -0,0 +1,45 @@
+#include "mappedfile.h"
+#include <Windows.h>
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(path const &filePath) {
+    Close();
+    HANDLE file = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    mFile = file;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        Close();
+        return false;
+    }
+    mMapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mMapping) {
+        Close();
+        return false;
+    }
+    mData = static_cast<uint8_t const *>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+    if (!mData) {
+        Close();
+        return false;
+    }
+    mSize = size_t(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (mData)
+        UnmapViewOfFile(mData);
+    if (mMapping)
+        CloseHandle(mMapping);
+    if (mFile)
+        CloseHandle(mFile);
+    mData = nullptr;
+    mMapping = nullptr;
+    mFile = nullptr;
+    mSize = 0;
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "Rx3Utils.h"
+#include <cstdint>
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+    void *mFile = nullptr;
+    void *mMapping = nullptr;
+    uint8_t const *mData = nullptr;
+    size_t mSize = 0;
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(MappedFile const &) = delete;
+    MappedFile &operator=(MappedFile const &) = delete;
+    bool Open(path const &filePath);
+    void Close();
+    uint8_t const *Data() const { return mData; }
+    size_t Size() const { return mSize; }
+};
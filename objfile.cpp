@@ -0,0 +1,398 @@
+#include "objfile.h"
+#include "mappedfile.h"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <unordered_map>
+#include <emmintrin.h>
+
+using namespace rx3utils;
+
+namespace {
+
+// first '\n' in [p, end), or end
+char const *FindNewline(char const *p, char const *end) {
+    __m128i const newline = _mm_set1_epi8('\n');
+    for (; p + 16 <= end; p += 16) {
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(p)), newline));
+        if (mask)
+            return p + std::countr_zero(unsigned(mask));
+    }
+    while (p < end && *p != '\n')
+        p++;
+    return p;
+}
+
+char const *SkipSpaces(char const *p, char const *end) {
+    while (p < end && (*p == ' ' || *p == '\t'))
+        p++;
+    return p;
+}
+
+bool ParseFloats(char const *p, char const *end, float *values, size_t count, size_t &numParsed) {
+    numParsed = 0;
+    for (; numParsed < count; numParsed++) {
+        p = SkipSpaces(p, end);
+        auto result = std::from_chars(p, end, values[numParsed]);
+        if (result.ec != std::errc())
+            break;
+        p = result.ptr;
+    }
+    return numParsed > 0;
+}
+
+struct FaceVertex {
+    int position = 0;
+    int uv = 0;
+    int normal = 0;
+    bool operator==(FaceVertex const &) const = default;
+};
+
+struct FaceVertexHash {
+    size_t operator()(FaceVertex const &v) const {
+        // 32-bit multiplicative mix, the same on Win32 and x64
+        uint32_t h = uint32_t(v.position) * 0x9E3779B1u;
+        h ^= uint32_t(v.uv) * 0x85EBCA77u;
+        h ^= uint32_t(v.normal) * 0xC2B2AE3Du;
+        return size_t(h ^ (h >> 15));
+    }
+};
+
+// "7", "7/3", "7//2", "7/3/2", negative values count from the end of the pool
+char const *ParseFaceVertex(char const *p, char const *end, FaceVertex &v) {
+    int *fields[3] = { &v.position, &v.uv, &v.normal };
+    v = {};
+    for (int f = 0; f < 3; f++) {
+        if (p < end && *p != '/' && *p != ' ' && *p != '\t' && *p != '\r') {
+            auto result = std::from_chars(p, end, *fields[f]);
+            if (result.ec != std::errc())
+                return nullptr;
+            p = result.ptr;
+        }
+        if (p >= end || *p != '/')
+            break;
+        p++;
+    }
+    return v.position ? p : nullptr;
+}
+
+int ResolveIndex(int index, size_t poolSize) {
+    if (index > 0)
+        return index - 1 < int(poolSize) ? index - 1 : -1;
+    if (index < 0)
+        return int(poolSize) + index >= 0 ? int(poolSize) + index : -1;
+    return -1;
+}
+
+class ObjReader {
+    vector<float> mPositions, mUvs, mNormals, mColors;
+    bool mHasColors = false;
+    std::unordered_map<FaceVertex, uint32_t, FaceVertexHash> mVertexMap;
+    string mObjectName = "default", mMaterial;
+    SceneMesh *mMesh = nullptr;
+    Scene &mScene;
+public:
+    ObjReader(Scene &scene) : mScene(scene) {}
+
+    void StartMesh() {
+        mMesh = nullptr;
+        mVertexMap.clear();
+    }
+
+    uint32_t AddVertex(FaceVertex const &fv) {
+        auto [it, added] = mVertexMap.try_emplace(fv, uint32_t(mMesh->NumVertices()));
+        if (!added)
+            return it->second;
+        int p = fv.position, t = fv.uv, n = fv.normal;
+        mMesh->positions.insert(mMesh->positions.end(), &mPositions[p * 3], &mPositions[p * 3] + 3);
+        if (!mNormals.empty()) {
+            if (n >= 0)
+                mMesh->normals.insert(mMesh->normals.end(), &mNormals[n * 3], &mNormals[n * 3] + 3);
+            else
+                mMesh->normals.insert(mMesh->normals.end(), { 0.0f, 0.0f, 0.0f });
+        }
+        if (!mUvs.empty()) {
+            mMesh->uvs.resize(1);
+            mMesh->uvs[0].push_back(t >= 0 ? mUvs[t * 2] : 0.0f);
+            mMesh->uvs[0].push_back(t >= 0 ? 1.0f - mUvs[t * 2 + 1] : 0.0f);
+        }
+        if (mHasColors) {
+            mMesh->colors.resize(1);
+            for (int c = 0; c < 3; c++)
+                mMesh->colors[0].push_back(uint8_t(std::lround(std::clamp(mColors[p * 3 + c], 0.0f, 1.0f) * 255.0f)));
+            mMesh->colors[0].push_back(255);
+        }
+        return it->second;
+    }
+
+    bool ReadFace(char const *p, char const *end) {
+        if (!mMesh) {
+            mMesh = &mScene.meshes.emplace_back();
+            mMesh->name = mObjectName;
+            mMesh->material = mMaterial;
+        }
+        uint32_t first = 0, previous = 0;
+        size_t numCorners = 0;
+        while ((p = SkipSpaces(p, end)) < end && *p != '\r') {
+            FaceVertex fv;
+            p = ParseFaceVertex(p, end, fv);
+            if (!p)
+                return false;
+            fv.position = ResolveIndex(fv.position, mPositions.size() / 3);
+            fv.uv = fv.uv ? ResolveIndex(fv.uv, mUvs.size() / 2) : -1;
+            fv.normal = fv.normal ? ResolveIndex(fv.normal, mNormals.size() / 3) : -1;
+            if (fv.position < 0)
+                return false;
+            uint32_t index = AddVertex(fv);
+            if (numCorners == 0)
+                first = index;
+            else if (numCorners >= 2)
+                mMesh->indices.insert(mMesh->indices.end(), { first, previous, index });
+            previous = index;
+            numCorners++;
+        }
+        return true;
+    }
+
+    bool ReadLine(char const *p, char const *end) {
+        p = SkipSpaces(p, end);
+        if (p >= end || *p == '#')
+            return true;
+        char const *keyEnd = p;
+        while (keyEnd < end && *keyEnd != ' ' && *keyEnd != '\t' && *keyEnd != '\r')
+            keyEnd++;
+        std::string_view key(p, keyEnd - p);
+        float values[6];
+        size_t numParsed;
+        if (key == "v") {
+            if (!ParseFloats(keyEnd, end, values, 6, numParsed) || numParsed < 3)
+                return false;
+            mPositions.insert(mPositions.end(), values, values + 3);
+            if (numParsed == 6 && !mHasColors) {
+                // colors of earlier vertices are white
+                mHasColors = true;
+                mColors.resize(mPositions.size() - 3, 1.0f);
+            }
+            if (mHasColors)
+                mColors.insert(mColors.end(), { numParsed == 6 ? values[3] : 1.0f, numParsed == 6 ? values[4] : 1.0f, numParsed == 6 ? values[5] : 1.0f });
+        }
+        else if (key == "vt") {
+            if (!ParseFloats(keyEnd, end, values, 2, numParsed))
+                return false;
+            mUvs.insert(mUvs.end(), { values[0], numParsed > 1 ? values[1] : 0.0f });
+        }
+        else if (key == "vn") {
+            if (!ParseFloats(keyEnd, end, values, 3, numParsed) || numParsed < 3)
+                return false;
+            mNormals.insert(mNormals.end(), values, values + 3);
+        }
+        else if (key == "f")
+            return ReadFace(keyEnd, end);
+        else if (key == "o" || key == "g" || key == "usemtl") {
+            char const *valueEnd = end;
+            while (valueEnd > keyEnd && (valueEnd[-1] == '\r' || valueEnd[-1] == ' ' || valueEnd[-1] == '\t'))
+                valueEnd--;
+            char const *value = SkipSpaces(keyEnd, valueEnd);
+            string name(value, valueEnd - value);
+            if (key == "usemtl") {
+                if (name == mMaterial)
+                    return true;
+                mMaterial = name;
+            }
+            else {
+                if (name.empty() || name == mObjectName)
+                    return true;
+                mObjectName = name;
+            }
+            StartMesh();
+        }
+        return true;
+    }
+
+    bool Read(char const *data, size_t size) {
+        char const *end = data + size;
+        for (char const *p = data; p < end;) {
+            char const *lineEnd = FindNewline(p, end);
+            if (!ReadLine(p, lineEnd))
+                return false;
+            p = lineEnd + 1;
+        }
+        // meshes split by material keep unique names
+        map<string, int> nameCounts;
+        for (auto &mesh : mScene.meshes) {
+            int count = nameCounts[mesh.name]++;
+            if (count)
+                mesh.name += "_" + to_string(count);
+        }
+        // vertices of meshes with only some normals/uvs were filled before the first one appeared
+        for (auto &mesh : mScene.meshes) {
+            size_t numVertices = mesh.NumVertices();
+            if (!mesh.normals.empty() && mesh.normals.size() != numVertices * 3)
+                mesh.normals.insert(mesh.normals.begin(), numVertices * 3 - mesh.normals.size(), 0.0f);
+            if (!mesh.uvs.empty() && mesh.uvs[0].size() != numVertices * 2)
+                mesh.uvs[0].insert(mesh.uvs[0].begin(), numVertices * 2 - mesh.uvs[0].size(), 0.0f);
+            if (!mesh.colors.empty() && mesh.colors[0].size() != numVertices * 4)
+                mesh.colors[0].insert(mesh.colors[0].begin(), numVertices * 4 - mesh.colors[0].size(), 255);
+        }
+        return true;
+    }
+};
+
+// to_chars output collected in blocks of a few MB before each write
+class BlockWriter {
+    std::ofstream mFile;
+    vector<char> mBlock;
+    size_t mUsed = 0;
+public:
+    static size_t const BLOCK_SIZE = 4 * 1024 * 1024;
+
+    BlockWriter(path const &filePath) : mFile(filePath, std::ios::binary), mBlock(BLOCK_SIZE) {}
+    ~BlockWriter() { Flush(); }
+
+    bool IsOpen() const { return mFile.is_open(); }
+    bool Good() const { return mFile.good(); }
+
+    void Flush() {
+        mFile.write(mBlock.data(), mUsed);
+        mUsed = 0;
+    }
+
+    // room for a line of numbers
+    void Reserve() {
+        if (mUsed + 256 > mBlock.size())
+            Flush();
+    }
+
+    void Text(std::string_view text) {
+        if (mUsed + text.size() > mBlock.size()) {
+            Flush();
+            if (text.size() > mBlock.size()) {
+                mFile.write(text.data(), text.size());
+                return;
+            }
+        }
+        memcpy(mBlock.data() + mUsed, text.data(), text.size());
+        mUsed += text.size();
+    }
+
+    void Char(char c) { mBlock[mUsed++] = c; }
+
+    template<typename T> void Number(T value) {
+        auto result = std::to_chars(mBlock.data() + mUsed, mBlock.data() + mBlock.size(), value);
+        mUsed = result.ptr - mBlock.data();
+    }
+};
+
+}
+
+bool ReadObj(path const &filePath, Scene &scene) {
+    MappedFile file;
+    if (!file.Open(filePath))
+        return false;
+    scene = Scene();
+    ObjReader reader(scene);
+    return reader.Read(reinterpret_cast<char const *>(file.Data()), file.Size());
+}
+
+bool WriteObj(Scene const &scene, path const &filePath) {
+    vector<string> materials;
+    for (auto const &mesh : scene.meshes) {
+        if (!mesh.material.empty() && find(materials.begin(), materials.end(), mesh.material) == materials.end())
+            materials.push_back(mesh.material);
+    }
+    path mtlPath = filePath;
+    mtlPath.replace_extension(L".mtl");
+    if (!materials.empty()) {
+        BlockWriter mtl(mtlPath);
+        if (!mtl.IsOpen())
+            return false;
+        for (auto const &material : materials) {
+            mtl.Text("newmtl ");
+            mtl.Text(material);
+            mtl.Text("\n");
+        }
+        mtl.Flush();
+        if (!mtl.Good())
+            return false;
+    }
+    BlockWriter obj(filePath);
+    if (!obj.IsOpen())
+        return false;
+    if (!materials.empty()) {
+        obj.Text("mtllib ");
+        obj.Text(ToUTF8(mtlPath.filename().c_str()));
+        obj.Text("\n");
+    }
+    // v, vt and vn are numbered separately, meshes without uvs or normals don't advance those counts
+    size_t positionBase = 1, uvBase = 1, normalBase = 1;
+    for (auto const &mesh : scene.meshes) {
+        size_t numVertices = mesh.NumVertices();
+        bool hasNormals = mesh.normals.size() == numVertices * 3 && numVertices;
+        bool hasUvs = !mesh.uvs.empty() && mesh.uvs[0].size() == numVertices * 2;
+        bool hasColors = !mesh.colors.empty() && mesh.colors[0].size() == numVertices * 4;
+        obj.Text("o ");
+        obj.Text(mesh.name);
+        obj.Text("\n");
+        if (!mesh.material.empty()) {
+            obj.Text("usemtl ");
+            obj.Text(mesh.material);
+            obj.Text("\n");
+        }
+        for (size_t i = 0; i < numVertices; i++) {
+            obj.Reserve();
+            obj.Char('v');
+            for (size_t c = 0; c < 3; c++) {
+                obj.Char(' ');
+                obj.Number(mesh.positions[i * 3 + c]);
+            }
+            for (size_t c = 0; hasColors && c < 3; c++) {
+                obj.Char(' ');
+                obj.Number(mesh.colors[0][i * 4 + c] / 255.0f);
+            }
+            obj.Char('\n');
+        }
+        for (size_t i = 0; hasUvs && i < numVertices; i++) {
+            obj.Reserve();
+            obj.Text("vt ");
+            obj.Number(mesh.uvs[0][i * 2]);
+            obj.Char(' ');
+            obj.Number(1.0f - mesh.uvs[0][i * 2 + 1]);
+            obj.Char('\n');
+        }
+        for (size_t i = 0; hasNormals && i < numVertices; i++) {
+            obj.Reserve();
+            obj.Text("vn");
+            for (size_t c = 0; c < 3; c++) {
+                obj.Char(' ');
+                obj.Number(mesh.normals[i * 3 + c]);
+            }
+            obj.Char('\n');
+        }
+        for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3) {
+            obj.Reserve();
+            obj.Char('f');
+            for (size_t c = 0; c < 3; c++) {
+                size_t index = mesh.indices[t + c];
+                obj.Char(' ');
+                obj.Number(positionBase + index);
+                if (hasUvs || hasNormals) {
+                    obj.Char('/');
+                    if (hasUvs)
+                        obj.Number(uvBase + index);
+                    if (hasNormals) {
+                        obj.Char('/');
+                        obj.Number(normalBase + index);
+                    }
+                }
+            }
+            obj.Char('\n');
+        }
+        positionBase += numVertices;
+        uvBase += hasUvs ? numVertices : 0;
+        normalBase += hasNormals ? numVertices : 0;
+    }
+    obj.Flush();
+    return obj.Good();
+}
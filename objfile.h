@@ -0,0 +1,11 @@
+#pragma once
+#include "scene.h"
+
+// Wavefront OBJ. The reader maps the file, finds lines with an SSE2 newline scan and parses numbers with
+// std::from_chars; objects and material changes start new meshes, polygons are fan-triangulated, "v x y z r g b"
+// vertex colors are kept. The writer formats with std::to_chars into large blocks and writes a .mtl with
+// the material names only (no texture maps). Texture v is flipped in both directions (OBJ has its origin at the bottom).
+// The writer only writes triangles; -exportQuads exports and models with materials go through rx3lib, whose .mtl
+// references the exported textures. Imports use ReadObj only with -fastObj.
+bool ReadObj(path const &filePath, Scene &scene);
+bool WriteObj(Scene const &scene, path const &filePath);
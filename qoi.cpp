@@ -0,0 +1,182 @@
+#include "qoi.h"
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+
+static constexpr uint8_t QOI_OP_INDEX = 0x00;
+static constexpr uint8_t QOI_OP_DIFF = 0x40;
+static constexpr uint8_t QOI_OP_LUMA = 0x80;
+static constexpr uint8_t QOI_OP_RUN = 0xC0;
+static constexpr uint8_t QOI_OP_RGB = 0xFE;
+static constexpr uint8_t QOI_OP_RGBA = 0xFF;
+static constexpr uint8_t QOI_MASK_2 = 0xC0;
+static constexpr size_t QOI_HEADER_SIZE = 14;
+static constexpr uint8_t QOI_PADDING[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+struct QoiPixel {
+    uint8_t r = 0, g = 0, b = 0, a = 255;
+    bool operator==(QoiPixel const &) const = default;
+};
+
+static inline uint32_t QoiHash(QoiPixel const &p) {
+    return (p.r * 3 + p.g * 5 + p.b * 7 + p.a * 11) % 64;
+}
+
+static void Write32BE(uint8_t *p, uint32_t v) {
+    p[0] = uint8_t(v >> 24);
+    p[1] = uint8_t(v >> 16);
+    p[2] = uint8_t(v >> 8);
+    p[3] = uint8_t(v);
+}
+
+static uint32_t Read32BE(uint8_t const *p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+bool EncodeQOI(uint8_t const *rgba, uint32_t width, uint32_t height, size_t rowPitch, std::vector<uint8_t> &out) {
+    if (width == 0 || height == 0)
+        return false;
+    out.resize(QOI_HEADER_SIZE + size_t(width) * height * 5 + sizeof(QOI_PADDING));
+    uint8_t *p = out.data();
+    memcpy(p, "qoif", 4);
+    Write32BE(p + 4, width);
+    Write32BE(p + 8, height);
+    p[12] = 4;
+    p[13] = 0;
+    p += QOI_HEADER_SIZE;
+    // the index starts zeroed, alpha included, unlike a default QoiPixel
+    QoiPixel index[64];
+    std::fill(std::begin(index), std::end(index), QoiPixel{ 0, 0, 0, 0 });
+    QoiPixel prev;
+    uint32_t run = 0;
+    for (uint32_t y = 0; y < height; y++) {
+        uint8_t const *row = rgba + y * rowPitch;
+        for (uint32_t x = 0; x < width; x++) {
+            QoiPixel px = { row[x * 4], row[x * 4 + 1], row[x * 4 + 2], row[x * 4 + 3] };
+            if (px == prev) {
+                run++;
+                if (run == 62) {
+                    *p++ = QOI_OP_RUN | uint8_t(run - 1);
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                *p++ = QOI_OP_RUN | uint8_t(run - 1);
+                run = 0;
+            }
+            uint32_t h = QoiHash(px);
+            if (index[h] == px)
+                *p++ = QOI_OP_INDEX | uint8_t(h);
+            else {
+                index[h] = px;
+                if (px.a == prev.a) {
+                    int8_t vr = int8_t(px.r - prev.r);
+                    int8_t vg = int8_t(px.g - prev.g);
+                    int8_t vb = int8_t(px.b - prev.b);
+                    int8_t vgr = int8_t(vr - vg);
+                    int8_t vgb = int8_t(vb - vg);
+                    if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+                        *p++ = QOI_OP_DIFF | uint8_t((vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+                    else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8) {
+                        *p++ = QOI_OP_LUMA | uint8_t(vg + 32);
+                        *p++ = uint8_t((vgr + 8) << 4 | (vgb + 8));
+                    }
+                    else {
+                        *p++ = QOI_OP_RGB;
+                        *p++ = px.r;
+                        *p++ = px.g;
+                        *p++ = px.b;
+                    }
+                }
+                else {
+                    *p++ = QOI_OP_RGBA;
+                    *p++ = px.r;
+                    *p++ = px.g;
+                    *p++ = px.b;
+                    *p++ = px.a;
+                }
+            }
+            prev = px;
+        }
+    }
+    if (run > 0)
+        *p++ = QOI_OP_RUN | uint8_t(run - 1);
+    memcpy(p, QOI_PADDING, sizeof(QOI_PADDING));
+    p += sizeof(QOI_PADDING);
+    out.resize(p - out.data());
+    return true;
+}
+
+bool ReadQOIHeader(uint8_t const *data, size_t size, uint32_t &width, uint32_t &height) {
+    if (size < QOI_HEADER_SIZE + sizeof(QOI_PADDING) || memcmp(data, "qoif", 4) != 0)
+        return false;
+    width = Read32BE(data + 4);
+    height = Read32BE(data + 8);
+    return width != 0 && height != 0 && (data[12] == 3 || data[12] == 4);
+}
+
+bool DecodeQOI(uint8_t const *data, size_t size, uint8_t *rgba, uint32_t width, uint32_t height, size_t rowPitch) {
+    uint32_t w, h;
+    if (!ReadQOIHeader(data, size, w, h) || w != width || h != height)
+        return false;
+    uint8_t const *p = data + QOI_HEADER_SIZE;
+    uint8_t const *end = data + size - sizeof(QOI_PADDING);
+    QoiPixel index[64];
+    std::fill(std::begin(index), std::end(index), QoiPixel{ 0, 0, 0, 0 });
+    QoiPixel px;
+    uint32_t run = 0;
+    for (uint32_t y = 0; y < height; y++) {
+        uint8_t *row = rgba + y * rowPitch;
+        for (uint32_t x = 0; x < width; x++) {
+            if (run > 0)
+                run--;
+            else {
+                if (p >= end)
+                    return false;
+                uint8_t b1 = *p++;
+                if (b1 == QOI_OP_RGB) {
+                    if (end - p < 3)
+                        return false;
+                    px.r = p[0];
+                    px.g = p[1];
+                    px.b = p[2];
+                    p += 3;
+                }
+                else if (b1 == QOI_OP_RGBA) {
+                    if (end - p < 4)
+                        return false;
+                    px.r = p[0];
+                    px.g = p[1];
+                    px.b = p[2];
+                    px.a = p[3];
+                    p += 4;
+                }
+                else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX)
+                    px = index[b1];
+                else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF) {
+                    px.r += ((b1 >> 4) & 3) - 2;
+                    px.g += ((b1 >> 2) & 3) - 2;
+                    px.b += (b1 & 3) - 2;
+                }
+                else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA) {
+                    if (p >= end)
+                        return false;
+                    uint8_t b2 = *p++;
+                    int vg = (b1 & 0x3F) - 32;
+                    px.r += vg - 8 + ((b2 >> 4) & 0x0F);
+                    px.g += vg;
+                    px.b += vg - 8 + (b2 & 0x0F);
+                }
+                else
+                    run = b1 & 0x3F;
+                index[QoiHash(px)] = px;
+            }
+            row[x * 4] = px.r;
+            row[x * 4 + 1] = px.g;
+            row[x * 4 + 2] = px.b;
+            row[x * 4 + 3] = px.a;
+        }
+    }
+    return true;
+}
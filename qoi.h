@@ -0,0 +1,9 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// QOI ("Quite OK Image") lossless RGBA8 encoder/decoder, https://qoiformat.org/qoi-specification.pdf
+bool EncodeQOI(uint8_t const *rgba, uint32_t width, uint32_t height, size_t rowPitch, std::vector<uint8_t> &out);
+bool ReadQOIHeader(uint8_t const *data, size_t size, uint32_t &width, uint32_t &height);
+bool DecodeQOI(uint8_t const *data, size_t size, uint8_t *rgba, uint32_t width, uint32_t height, size_t rowPitch);
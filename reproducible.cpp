@@ -0,0 +1,106 @@
+#include "reproducible.h"
+#include "rx3file.h"
+#include <ctime>
+
+using namespace rx3utils;
+
+string ReproducibleCommandLine(int argc, wchar_t *argv[]) {
+    string result = "rx3c";
+    for (int i = 1; i < argc; i++) {
+        path arg = argv[i];
+        std::error_code ec;
+        bool isPath = arg.wstring().find_first_of(L"\\/:") != wstring::npos && exists(arg, ec);
+        result += " " + ToUTF8(isPath ? arg.filename().wstring() : arg.wstring());
+    }
+    return result;
+}
+
+path ReproduciblePath(path const &filePath, path const &root) {
+    return root.empty() ? filePath.filename() : path(relative(filePath, root).generic_wstring());
+}
+
+string ReproducibleSourceList(vector<path> const &sources, path const &root) {
+    string result;
+    for (auto const &source : sources) {
+        if (!result.empty())
+            result += ";";
+        result += ToUTF8(ReproduciblePath(source, root).c_str());
+    }
+    return result;
+}
+
+// rx3lib stamps metadata chunks with the time they were written. That field is the date/time text
+// ("yyyy-mm-dd hh:mm[:ss]", -/. as date and T or space as date/time separator) whose value falls within
+// [from, to], the time this run wrote the file; it is replaced with zeros. Dates in paths or from source
+// files are kept.
+static void ZeroTimestamps(vector<uint8_t> &data, std::time_t from, std::time_t to) {
+    auto Digits = [&](size_t pos, size_t count, int &value) {
+        value = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (pos + i >= data.size() || !isdigit(data[pos + i]))
+                return false;
+            value = value * 10 + (data[pos + i] - '0');
+        }
+        return true;
+    };
+    // the stamp covers [t, t + seconds), as local time or UTC
+    auto Overlaps = [&](std::tm t, std::time_t seconds) {
+        t.tm_isdst = -1;
+        std::tm utc = t;
+        for (std::time_t start : { std::mktime(&t), _mkgmtime(&utc) }) {
+            if (start != -1 && start <= to && start + seconds > from)
+                return true;
+        }
+        return false;
+    };
+    for (size_t p = 0; p + 16 <= data.size(); p++) {
+        std::tm t = {};
+        uint8_t sep = data[p + 4];
+        if (!Digits(p, 4, t.tm_year) || (sep != '-' && sep != '/' && sep != '.') || !Digits(p + 5, 2, t.tm_mon) || data[p + 7] != sep ||
+            !Digits(p + 8, 2, t.tm_mday) || (data[p + 10] != 'T' && data[p + 10] != ' ') || !Digits(p + 11, 2, t.tm_hour) ||
+            data[p + 13] != ':' || !Digits(p + 14, 2, t.tm_min))
+        {
+            continue;
+        }
+        size_t length = 16;
+        int seconds = 0;
+        if (p + 19 <= data.size() && data[p + 16] == ':' && Digits(p + 17, 2, seconds)) {
+            t.tm_sec = seconds;
+            length = 19;
+        }
+        t.tm_year -= 1900;
+        t.tm_mon -= 1;
+        if (!Overlaps(t, length == 16 ? 60 : 1))
+            continue;
+        for (size_t i = 0; i < length; i++) {
+            if (isdigit(data[p + i]))
+                data[p + i] = '0';
+        }
+        p += length - 1;
+    }
+}
+
+bool NormalizeRx3File(path const &rx3Path, std::time_t writtenSince) {
+    Rx3File rx3;
+    if (!rx3.Open(rx3Path))
+        return false;
+    Rx3FileWriter writer(rx3);
+    rx3.Close();
+    // texture chunks keep their slots, only their order among themselves changes
+    vector<size_t> textureSlots;
+    vector<Rx3FileWriter::Chunk> textures;
+    for (size_t i = 0; i < writer.mChunks.size(); i++) {
+        if (writer.mChunks[i].type == RX3_CHUNK_TEXTURE) {
+            textureSlots.push_back(i);
+            textures.push_back(std::move(writer.mChunks[i]));
+        }
+        else if (writer.mChunks[i].type == RX3_CHUNK_METADATA)
+            ZeroTimestamps(writer.mChunks[i].data, writtenSince, std::time(nullptr));
+    }
+    std::stable_sort(textures.begin(), textures.end(), [](Rx3FileWriter::Chunk const &a, Rx3FileWriter::Chunk const &b) {
+        return ToLower(a.name) < ToLower(b.name);
+    });
+    for (size_t t = 0; t < textures.size(); t++)
+        writer.mChunks[textureSlots[t]] = std::move(textures[t]);
+    return writer.Save(rx3Path);
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "Rx3Utils.h"
+#include <ctime>
+
+// -reproducible: metadata that doesn't depend on where or when rx3c ran, so identical inputs give
+// byte-identical rx3 files
+
+// Command line with the program path dropped and every argument naming an existing file or folder
+// reduced to its file name
+string ReproducibleCommandLine(int argc, wchar_t *argv[]);
+
+// A file relative to root ('/' separated), or just its name if root is empty; the form source paths take in
+// metadata
+path ReproduciblePath(path const &filePath, path const &root);
+
+// Source files as ReproduciblePath, ';' separated
+string ReproducibleSourceList(vector<path> const &sources, path const &root);
+
+// Rewrites an rx3 file in canonical form: texture chunks ordered by name, the time stamp rx3lib wrote into
+// metadata chunks (at or after writtenSince) replaced with zeros, names chunk regenerated, zero-filled padding
+bool NormalizeRx3File(path const &rx3Path, std::time_t writtenSince);
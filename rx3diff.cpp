@@ -0,0 +1,188 @@
+#include "rx3diff.h"
+#include "rx3file.h"
+#include "textures.h"
+#include "vertexdecl.h"
+#include "hash.h"
+#include <bit>
+#include <cmath>
+#include <execution>
+
+using namespace rx3utils;
+
+namespace {
+
+// unnamed chunks have an empty name; occurrence counts chunks of the same type and name, so duplicates
+// are paired in order instead of replacing each other
+struct ChunkKey {
+    uint32_t type;
+    string name;
+    size_t occurrence;
+    auto operator<=>(ChunkKey const &) const = default;
+};
+
+struct ChunkRef {
+    Rx3FileChunk const *chunk = nullptr;
+    size_t typeIndex = 0; // among all chunks of this type, pairs vertex buffers with their declarations
+    uint64_t hash = 0;
+};
+
+}
+
+static map<ChunkKey, ChunkRef> CollectChunks(Rx3File const &rx3) {
+    map<ChunkKey, ChunkRef> result;
+    map<uint32_t, size_t> typeIndices;
+    map<pair<uint32_t, string>, size_t> occurrences;
+    for (auto const &c : rx3.Chunks()) {
+        size_t typeIndex = typeIndices[c.type]++;
+        if (c.type == RX3_CHUNK_METADATA || c.type == RX3_CHUNK_NAMES)
+            continue;
+        string name = ToLower(c.name);
+        size_t occurrence = occurrences[{ c.type, name }]++;
+        result[{ c.type, name, occurrence }] = { &c, typeIndex, 0 };
+    }
+    return result;
+}
+
+static float HalfToFloat(uint16_t h) {
+    uint32_t sign = uint32_t(h & 0x8000) << 16;
+    uint32_t exponent = (h >> 10) & 0x1F;
+    uint32_t mantissa = h & 0x3FF;
+    if (exponent == 0) {
+        float value = std::ldexp(float(mantissa), -24);
+        return sign ? -value : value;
+    }
+    if (exponent == 31)
+        return std::bit_cast<float>(sign | 0x7F800000 | (mantissa << 13));
+    return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+static bool ReadPositions(Rx3File const &rx3, ChunkRef const &ref, vector<float> &positions) {
+    auto formats = rx3.FindChunks(RX3_CHUNK_VERTEX_FORMAT);
+    vector<Rx3VertexElement> elements;
+    if (ref.typeIndex >= formats.size() || !ReadRx3VertexDeclaration(rx3, *formats[ref.typeIndex], elements))
+        return false;
+    uint8_t const *data = rx3.ChunkData(*ref.chunk);
+    uint32_t numVertices = rx3.Read32(data + 4);
+    uint32_t vertexSize = rx3.Read32(data + 8);
+    if (16 + uint64_t(numVertices) * vertexSize > ref.chunk->size)
+        return false;
+    for (auto const &e : elements) {
+        bool isFloat = e.type == "f32" || e.type == "f16";
+        if (e.usage != "p0" || !isFloat || e.count < 3 || e.offset + e.Size() > vertexSize)
+            continue;
+        positions.resize(size_t(numVertices) * 3);
+        for (uint32_t v = 0; v < numVertices; v++) {
+            uint8_t const *p = data + 16 + size_t(v) * vertexSize + e.offset;
+            for (uint32_t c = 0; c < 3; c++) {
+                positions[v * 3 + c] = e.componentSize == 4 ? std::bit_cast<float>(rx3.Read32(p + c * 4)) :
+                    HalfToFloat(rx3.Read16(p + c * 2));
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+static void CompareVertexBuffers(Rx3File const &a, ChunkRef const &refA, Rx3File const &b, ChunkRef const &refB, nlohmann::ordered_json &out) {
+    uint32_t countA = a.Read32(a.ChunkData(*refA.chunk) + 4);
+    uint32_t countB = b.Read32(b.ChunkData(*refB.chunk) + 4);
+    if (countA != countB) {
+        out["vertices"] = { countA, countB };
+        return;
+    }
+    vector<float> positionsA, positionsB;
+    if (!ReadPositions(a, refA, positionsA) || !ReadPositions(b, refB, positionsB))
+        return;
+    float maxError = 0.0f;
+    for (size_t i = 0; i < positionsA.size(); i++)
+        maxError = max(maxError, std::fabs(positionsA[i] - positionsB[i]));
+    out["maxPositionError"] = maxError;
+}
+
+static void CompareTextures(Rx3File const &a, ChunkRef const &refA, Rx3File const &b, ChunkRef const &refB, nlohmann::ordered_json &out) {
+    Rx3TextureInfo infoA, infoB;
+    if (!ReadRx3TextureInfo(a, *refA.chunk, infoA) || !ReadRx3TextureInfo(b, *refB.chunk, infoB))
+        return;
+    if (infoA.format != infoB.format)
+        out["format"] = { Rx3TextureFormatName(infoA.format), Rx3TextureFormatName(infoB.format) };
+    if (infoA.width != infoB.width || infoA.height != infoB.height) {
+        out["dimensions"] = { to_string(infoA.width) + "x" + to_string(infoA.height), to_string(infoB.width) + "x" + to_string(infoB.height) };
+        return;
+    }
+    if (infoA.levels != infoB.levels)
+        out["levels"] = { infoA.levels, infoB.levels };
+    DirectX::ScratchImage imageA, imageB;
+    if (!DecodeRx3Texture(a, *refA.chunk, 0, imageA) || !DecodeRx3Texture(b, *refB.chunk, 0, imageB))
+        return;
+    auto const *pa = imageA.GetImage(0, 0, 0);
+    auto const *pb = imageB.GetImage(0, 0, 0);
+    if (pa->width != pb->width || pa->height != pb->height)
+        return;
+    uint64_t sumSquares = 0;
+    for (size_t y = 0; y < pa->height; y++) {
+        uint8_t const *rowA = pa->pixels + y * pa->rowPitch;
+        uint8_t const *rowB = pb->pixels + y * pb->rowPitch;
+        for (size_t x = 0; x < pa->width * 4; x++) {
+            int d = int(rowA[x]) - int(rowB[x]);
+            sumSquares += uint64_t(d * d);
+        }
+    }
+    double mse = double(sumSquares) / double(pa->width * pa->height * 4);
+    out["psnr"] = mse == 0.0 ? 999.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+nlohmann::ordered_json DiffRx3(path const &a, path const &b) {
+    nlohmann::ordered_json result;
+    Rx3File fileA, fileB;
+    bool openedA = fileA.Open(a), openedB = fileB.Open(b);
+    if (!openedA || !openedB) {
+        result["error"] = !openedA ? "can't read first file" : "can't read second file";
+        return result;
+    }
+    auto chunksA = CollectChunks(fileA);
+    auto chunksB = CollectChunks(fileB);
+    // chunks of both sides are hashed in parallel
+    vector<pair<Rx3File const *, ChunkRef *>> toHash;
+    for (auto &[key, ref] : chunksA)
+        toHash.emplace_back(&fileA, &ref);
+    for (auto &[key, ref] : chunksB)
+        toHash.emplace_back(&fileB, &ref);
+    std::for_each(std::execution::par, toHash.begin(), toHash.end(), [](auto &item) {
+        item.second->hash = Hash64(item.first->ChunkData(*item.second->chunk), item.second->chunk->size);
+    });
+    auto changes = nlohmann::ordered_json::array();
+    auto Describe = [](ChunkKey const &key, char const *status) {
+        nlohmann::ordered_json change;
+        change["type"] = Rx3ChunkTypeName(key.type);
+        if (!key.name.empty())
+            change["name"] = key.name;
+        if (key.name.empty() || key.occurrence != 0)
+            change["index"] = key.occurrence;
+        change["status"] = status;
+        return change;
+    };
+    for (auto const &[key, refA] : chunksA) {
+        auto it = chunksB.find(key);
+        if (it == chunksB.end()) {
+            changes.push_back(Describe(key, "removed"));
+            continue;
+        }
+        ChunkRef const &refB = it->second;
+        if (refA.hash == refB.hash && refA.chunk->size == refB.chunk->size)
+            continue;
+        auto change = Describe(key, "changed");
+        change["size"] = { refA.chunk->size, refB.chunk->size };
+        if (key.type == RX3_CHUNK_TEXTURE)
+            CompareTextures(fileA, refA, fileB, refB, change);
+        else if (key.type == RX3_CHUNK_VERTEX_BUFFER)
+            CompareVertexBuffers(fileA, refA, fileB, refB, change);
+        changes.push_back(change);
+    }
+    for (auto const &[key, refB] : chunksB) {
+        if (!chunksA.contains(key))
+            changes.push_back(Describe(key, "added"));
+    }
+    if (!changes.empty())
+        result["chunks"] = changes;
+    return result;
+}
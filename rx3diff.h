@@ -0,0 +1,9 @@
+#pragma once
+#include "Rx3Utils.h"
+#include "nlohmann/json.hpp"
+
+// Chunk-level comparison of two rx3 files. Chunks are matched by type and name, and by their order among
+// chunks of the same type and name (unnamed or duplicated ones), and compared by hash; metadata and names
+// chunks are ignored. Changed textures report PSNR of the top level, changed vertex buffers the maximum
+// position error. Returns an empty object if the files are equivalent.
+nlohmann::ordered_json DiffRx3(path const &a, path const &b);
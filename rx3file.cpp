@@ -0,0 +1,232 @@
+#include "rx3file.h"
+#include <bit>
+#include <fstream>
+
+using namespace rx3utils;
+
+static constexpr uint32_t RX3_HEADER_SIZE = 16;
+static constexpr uint32_t RX3_CHUNK_ENTRY_SIZE = 16;
+
+static size_t Align16(size_t value) {
+    return (value + 15) & ~size_t(15);
+}
+
+bool Rx3File::Open(path const &filePath) {
+    mBuffer.clear();
+    if (!mMapped.Open(filePath))
+        return false;
+    mData = mMapped.Data();
+    mSize = mMapped.Size();
+    return Parse();
+}
+
+bool Rx3File::Load(vector<uint8_t> data) {
+    mMapped.Close();
+    mBuffer = std::move(data);
+    mData = mBuffer.data();
+    mSize = mBuffer.size();
+    return Parse();
+}
+
+void Rx3File::Close() {
+    mMapped.Close();
+    mBuffer.clear();
+    mChunks.clear();
+    mData = nullptr;
+    mSize = 0;
+}
+
+uint16_t Rx3File::Read16(uint8_t const *p) const {
+    uint16_t value = uint16_t(p[0] | (p[1] << 8));
+    return mBigEndian ? std::byteswap(value) : value;
+}
+
+uint32_t Rx3File::Read32(uint8_t const *p) const {
+    uint32_t value = uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+    return mBigEndian ? std::byteswap(value) : value;
+}
+
+bool Rx3File::Parse() {
+    mChunks.clear();
+    if (mSize < RX3_HEADER_SIZE || memcmp(mData, "RX3", 3) != 0)
+        return false;
+    if (mData[3] == 'b')
+        mBigEndian = true;
+    else if (mData[3] == 'l')
+        mBigEndian = false;
+    else
+        return false;
+    uint32_t numChunks = Read32(mData + 12);
+    // 64-bit sums, size_t is 32 bits on Win32 and a malformed table could wrap it
+    if (RX3_HEADER_SIZE + uint64_t(numChunks) * RX3_CHUNK_ENTRY_SIZE > mSize)
+        return false;
+    mChunks.resize(numChunks);
+    for (uint32_t i = 0; i < numChunks; i++) {
+        uint8_t const *entry = mData + RX3_HEADER_SIZE + i * RX3_CHUNK_ENTRY_SIZE;
+        mChunks[i].type = Read32(entry);
+        mChunks[i].offset = Read32(entry + 4);
+        mChunks[i].size = Read32(entry + 8);
+        if (uint64_t(mChunks[i].offset) + mChunks[i].size > mSize)
+            return false;
+    }
+    auto namesChunks = FindChunks(RX3_CHUNK_NAMES);
+    if (!namesChunks.empty() && namesChunks[0]->size >= 16) {
+        uint8_t const *p = ChunkData(*namesChunks[0]);
+        uint8_t const *end = p + namesChunks[0]->size;
+        uint32_t numNames = Read32(p + 4);
+        p += 16;
+        map<uint32_t, size_t> nextIndex;
+        for (uint32_t n = 0; n < numNames && size_t(end - p) >= 8; n++) {
+            uint32_t type = Read32(p);
+            uint32_t length = Read32(p + 4);
+            p += 8;
+            if (length > size_t(end - p))
+                break;
+            string name(reinterpret_cast<char const *>(p), strnlen(reinterpret_cast<char const *>(p), length));
+            p += length;
+            size_t &index = nextIndex[type];
+            for (; index < mChunks.size(); index++) {
+                if (mChunks[index].type == type) {
+                    mChunks[index++].name = name;
+                    break;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+vector<Rx3FileChunk const *> Rx3File::FindChunks(uint32_t type) const {
+    vector<Rx3FileChunk const *> result;
+    for (auto const &c : mChunks) {
+        if (c.type == type)
+            result.push_back(&c);
+    }
+    return result;
+}
+
+string Rx3ChunkTypeName(uint32_t type) {
+    switch (type) {
+    case RX3_CHUNK_TEXTURE_BATCH: return "textureBatch";
+    case RX3_CHUNK_TEXTURE: return "texture";
+    case RX3_CHUNK_NAMES: return "names";
+    case RX3_CHUNK_HOTSPOT: return "hotspot";
+    case RX3_CHUNK_VERTEX_FORMAT: return "vertexFormat";
+    case RX3_CHUNK_VERTEX_BUFFER: return "vertexBuffer";
+    case RX3_CHUNK_INDEX_BUFFER: return "indexBuffer";
+    case RX3_CHUNK_PRIMITIVE_TYPE: return "primitiveType";
+    case RX3_CHUNK_SKELETON: return "skeleton";
+    case RX3_CHUNK_MORPH: return "morph";
+    case RX3_CHUNK_METADATA: return "metadata";
+    }
+    return to_string(type);
+}
+
+Rx3FileWriter::Rx3FileWriter(bool bigEndian) : mBigEndian(bigEndian) {}
+
+Rx3FileWriter::Rx3FileWriter(Rx3File const &source) : mBigEndian(source.IsBigEndian()) {
+    for (auto const &c : source.Chunks())
+        AddChunk(c.type, source.ChunkData(c), c.size, c.name);
+}
+
+Rx3FileWriter::Chunk &Rx3FileWriter::AddChunk(uint32_t type, uint8_t const *data, size_t size, string const &name) {
+    auto &chunk = mChunks.emplace_back();
+    chunk.type = type;
+    chunk.data.assign(data, data + size);
+    chunk.name = name;
+    return chunk;
+}
+
+vector<Rx3FileWriter::Chunk *> Rx3FileWriter::FindChunks(uint32_t type) {
+    vector<Chunk *> result;
+    for (auto &c : mChunks) {
+        if (c.type == type)
+            result.push_back(&c);
+    }
+    return result;
+}
+
+void Rx3FileWriter::Write16(uint8_t *p, uint16_t value) const {
+    if (mBigEndian)
+        value = std::byteswap(value);
+    p[0] = uint8_t(value);
+    p[1] = uint8_t(value >> 8);
+}
+
+void Rx3FileWriter::Write32(uint8_t *p, uint32_t value) const {
+    if (mBigEndian)
+        value = std::byteswap(value);
+    p[0] = uint8_t(value);
+    p[1] = uint8_t(value >> 8);
+    p[2] = uint8_t(value >> 16);
+    p[3] = uint8_t(value >> 24);
+}
+
+void Rx3FileWriter::UpdateTextureBatchCount() {
+    auto batches = FindChunks(RX3_CHUNK_TEXTURE_BATCH);
+    if (!batches.empty() && batches[0]->data.size() >= 4)
+        Write32(batches[0]->data.data(), uint32_t(FindChunks(RX3_CHUNK_TEXTURE).size()));
+}
+
+vector<uint8_t> Rx3FileWriter::Build() const {
+    vector<Chunk> chunks = mChunks;
+    vector<Chunk const *> named;
+    for (auto const &c : chunks) {
+        if (c.type != RX3_CHUNK_NAMES && !c.name.empty())
+            named.push_back(&c);
+    }
+    if (!named.empty()) {
+        vector<uint8_t> names(16);
+        for (auto const *c : named) {
+            size_t pos = names.size();
+            names.resize(pos + 8 + c->name.size() + 1);
+            Write32(&names[pos], c->type);
+            Write32(&names[pos + 4], uint32_t(c->name.size() + 1));
+            memcpy(&names[pos + 8], c->name.data(), c->name.size());
+        }
+        Write32(&names[0], uint32_t(names.size()));
+        Write32(&names[4], uint32_t(named.size()));
+        bool replaced = false;
+        for (auto &c : chunks) {
+            if (c.type == RX3_CHUNK_NAMES) {
+                c.data = names;
+                replaced = true;
+                break;
+            }
+        }
+        if (!replaced) {
+            auto &c = chunks.emplace_back();
+            c.type = RX3_CHUNK_NAMES;
+            c.data = std::move(names);
+        }
+    }
+    size_t offset = Align16(RX3_HEADER_SIZE + chunks.size() * RX3_CHUNK_ENTRY_SIZE);
+    vector<size_t> offsets(chunks.size());
+    for (size_t i = 0; i < chunks.size(); i++) {
+        offsets[i] = offset;
+        offset = Align16(offset + chunks[i].data.size());
+    }
+    vector<uint8_t> out(offset, 0);
+    memcpy(out.data(), mBigEndian ? "RX3b" : "RX3l", 4);
+    Write32(&out[4], 4);
+    Write32(&out[8], uint32_t(out.size()));
+    Write32(&out[12], uint32_t(chunks.size()));
+    for (size_t i = 0; i < chunks.size(); i++) {
+        uint8_t *entry = &out[RX3_HEADER_SIZE + i * RX3_CHUNK_ENTRY_SIZE];
+        Write32(entry, chunks[i].type);
+        Write32(entry + 4, uint32_t(offsets[i]));
+        Write32(entry + 8, uint32_t(chunks[i].data.size()));
+        if (!chunks[i].data.empty())
+            memcpy(&out[offsets[i]], chunks[i].data.data(), chunks[i].data.size());
+    }
+    return out;
+}
+
+bool Rx3FileWriter::Save(path const &filePath) const {
+    auto data = Build();
+    std::ofstream file(filePath, std::ios::binary);
+    if (!file.is_open())
+        return false;
+    file.write(reinterpret_cast<char const *>(data.data()), data.size());
+    return file.good();
+}
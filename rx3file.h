@@ -0,0 +1,63 @@
+#pragma once
+#include "Rx3Utils.h"
+#include "Rx3Container.h"
+#include "mappedfile.h"
+#include <cstdint>
+
+// Raw view of an rx3 file: header, chunk table and chunk names, without decoding any payload
+struct Rx3FileChunk {
+    uint32_t type = 0;
+    uint32_t offset = 0;
+    uint32_t size = 0;
+    string name;
+};
+
+class Rx3File {
+    MappedFile mMapped;
+    vector<uint8_t> mBuffer;
+    uint8_t const *mData = nullptr;
+    size_t mSize = 0;
+    bool mBigEndian = false;
+    vector<Rx3FileChunk> mChunks;
+
+    bool Parse();
+public:
+    bool Open(path const &filePath);
+    bool Load(vector<uint8_t> data);
+    void Close();
+    bool IsBigEndian() const { return mBigEndian; }
+    uint8_t const *Data() const { return mData; }
+    size_t Size() const { return mSize; }
+    vector<Rx3FileChunk> const &Chunks() const { return mChunks; }
+    vector<Rx3FileChunk const *> FindChunks(uint32_t type) const;
+    uint8_t const *ChunkData(Rx3FileChunk const &chunk) const { return mData + chunk.offset; }
+    uint16_t Read16(uint8_t const *p) const;
+    uint32_t Read32(uint8_t const *p) const;
+};
+
+// Short name of a known chunk type ("texture", "vertexBuffer", ...), the decimal id otherwise
+string Rx3ChunkTypeName(uint32_t type);
+
+// Chunks are written in the order they were added, 16-byte aligned, with zero-filled padding.
+// The names chunk is regenerated from chunk names on Build().
+class Rx3FileWriter {
+    bool mBigEndian;
+public:
+    struct Chunk {
+        uint32_t type = 0;
+        vector<uint8_t> data;
+        string name;
+    };
+    vector<Chunk> mChunks;
+
+    Rx3FileWriter(bool bigEndian);
+    Rx3FileWriter(Rx3File const &source);
+    bool IsBigEndian() const { return mBigEndian; }
+    Chunk &AddChunk(uint32_t type, uint8_t const *data, size_t size, string const &name = string());
+    vector<Chunk *> FindChunks(uint32_t type);
+    void Write16(uint8_t *p, uint16_t value) const;
+    void Write32(uint8_t *p, uint32_t value) const;
+    void UpdateTextureBatchCount();
+    vector<uint8_t> Build() const;
+    bool Save(path const &filePath) const;
+};
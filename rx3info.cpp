@@ -0,0 +1,41 @@
+#include "rx3info.h"
+#include "textures.h"
+
+using namespace rx3utils;
+
+nlohmann::ordered_json ReadRx3Info(Rx3File const &rx3) {
+    nlohmann::ordered_json info;
+    info["endianness"] = rx3.IsBigEndian() ? "big" : "little";
+    info["size"] = rx3.Size();
+    auto &chunks = info["chunks"] = nlohmann::ordered_json::object();
+    map<string, uint32_t> histogram;
+    for (auto const &c : rx3.Chunks())
+        histogram[Rx3ChunkTypeName(c.type)]++;
+    for (auto const &[type, count] : histogram)
+        chunks[type] = count;
+    auto &textures = info["textures"] = nlohmann::ordered_json::array();
+    for (auto const *t : rx3.FindChunks(RX3_CHUNK_TEXTURE)) {
+        Rx3TextureInfo tex;
+        if (!ReadRx3TextureInfo(rx3, *t, tex))
+            continue;
+        textures.push_back({ { "name", t->name }, { "width", tex.width }, { "height", tex.height },
+            { "format", Rx3TextureFormatName(tex.format) }, { "levels", tex.levels }, { "faces", tex.NumFaces() }, { "depth", tex.depth } });
+    }
+    uint64_t numVertices = 0, numIndices = 0;
+    auto vertexBuffers = rx3.FindChunks(RX3_CHUNK_VERTEX_BUFFER);
+    for (auto const *vb : vertexBuffers) {
+        if (vb->size >= 16)
+            numVertices += rx3.Read32(rx3.ChunkData(*vb) + 4);
+    }
+    for (auto const *ib : rx3.FindChunks(RX3_CHUNK_INDEX_BUFFER)) {
+        if (ib->size >= 16)
+            numIndices += rx3.Read32(rx3.ChunkData(*ib) + 4);
+    }
+    info["meshes"] = vertexBuffers.size();
+    info["vertices"] = numVertices;
+    info["indices"] = numIndices;
+    info["skeleton"] = !rx3.FindChunks(RX3_CHUNK_SKELETON).empty();
+    info["morphs"] = !rx3.FindChunks(RX3_CHUNK_MORPH).empty();
+    info["hotspot"] = !rx3.FindChunks(RX3_CHUNK_HOTSPOT).empty();
+    return info;
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include "rx3file.h"
+#include "nlohmann/json.hpp"
+
+// Summary of an rx3 file built from the chunk table and chunk headers only: chunk type histogram,
+// texture names, dimensions and formats, mesh, vertex and index counts, skeleton/morph presence
+nlohmann::ordered_json ReadRx3Info(Rx3File const &rx3);
@@ -0,0 +1,45 @@
+#include "rx3patch.h"
+#include "rx3file.h"
+
+using namespace rx3utils;
+
+bool PatchRx3(path const &target, path const &patch, path const &out) {
+    Rx3File original, changes;
+    if (!original.Open(target) || !changes.Open(patch) || original.IsBigEndian() != changes.IsBigEndian())
+        return false;
+    Rx3FileWriter writer(original);
+    for (auto const &c : changes.Chunks()) {
+        if (c.type == RX3_CHUNK_NAMES || c.type == RX3_CHUNK_TEXTURE_BATCH)
+            continue;
+        uint8_t const *data = changes.ChunkData(c);
+        auto existing = writer.FindChunks(c.type);
+        Rx3FileWriter::Chunk *match = nullptr;
+        if (!c.name.empty()) {
+            string name = ToLower(c.name);
+            for (auto *e : existing) {
+                if (ToLower(e->name) == name) {
+                    match = e;
+                    break;
+                }
+            }
+        }
+        else if (existing.size() == 1 && changes.FindChunks(c.type).size() == 1)
+            match = existing.front();
+        if (match) {
+            match->data.assign(data, data + c.size);
+            continue;
+        }
+        Rx3FileWriter::Chunk chunk;
+        chunk.type = c.type;
+        chunk.data.assign(data, data + c.size);
+        chunk.name = c.name;
+        auto position = writer.mChunks.end();
+        if (!existing.empty())
+            position = writer.mChunks.begin() + (existing.back() - writer.mChunks.data()) + 1;
+        writer.mChunks.insert(position, std::move(chunk));
+    }
+    writer.UpdateTextureBatchCount();
+    original.Close();
+    changes.Close();
+    return writer.Save(out);
+}
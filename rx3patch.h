@@ -0,0 +1,7 @@
+#pragma once
+#include "Rx3Utils.h"
+
+// Writes target with the chunks of patch merged in: named chunks replace target chunks of the same type and
+// name (case-insensitive), a single unnamed chunk replaces the single target chunk of its type, anything else
+// is inserted after the last target chunk of its type. All other chunks are copied byte for byte.
+bool PatchRx3(path const &target, path const &patch, path const &out);
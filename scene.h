@@ -0,0 +1,59 @@
+#pragma once
+#include "Rx3Utils.h"
+#include "Model.h"
+#include <array>
+#include <cstdint>
+
+// Flat, structure-of-arrays mesh data shared by the rx3c model readers, writers and caches.
+// Model (ModelLibrary) is converted to and from it in scenemodel.cpp only.
+struct SceneMorph {
+    string name;
+    vector<float> positions; // xyz target positions, one per vertex
+    vector<float> normals;   // xyz target normals, empty if the target has none
+};
+
+constexpr uint16_t SCENE_NO_JOINT = 0xFFFF;
+
+struct SceneMesh {
+    string name;
+    string material;
+    vector<float> positions;        // xyz
+    vector<float> normals;          // xyz, empty if absent
+    vector<vector<float>> uvs;      // uv per set
+    vector<vector<uint8_t>> colors; // rgba8 per set
+    uint32_t numInfluences = 0;     // joint/weight slots per vertex
+    vector<uint16_t> joints;        // numInfluences per vertex, SCENE_NO_JOINT (weight 0) in unused slots; empty if not skinned
+    vector<float> weights;          // numInfluences per vertex, matching joints
+    vector<uint32_t> indices;       // triangle list
+    vector<SceneMorph> morphs;
+
+    size_t NumVertices() const { return positions.size() / 3; }
+};
+
+// Column-major 4x4 for column vectors
+using SceneMatrix = std::array<float, 16>;
+
+// transform is relative to the parent bone; parent is kept as stored, it may come after the bone
+struct SceneBone {
+    string name;
+    int32_t parent = -1;
+    SceneMatrix transform = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+    SceneMatrix inverseBind = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+};
+
+struct Scene {
+    vector<SceneMesh> meshes;
+    vector<SceneBone> bones;
+};
+
+SceneMatrix MultiplySceneMatrices(SceneMatrix const &a, SceneMatrix const &b);
+// singular matrices give identity
+SceneMatrix InvertSceneMatrix(SceneMatrix const &m);
+// Parents may come after their children. Writers build hierarchies from SceneBoneParents: the bone that closes
+// a parent cycle and bones with an invalid parent get -1 (become roots), so every bone has a root above it.
+vector<int32_t> SceneBoneParents(vector<SceneBone> const &bones);
+vector<SceneMatrix> GlobalBoneMatrices(vector<SceneBone> const &bones);
+
+// every Model field rx3c uses survives ModelToScene followed by SceneToModel, influences with zero weight included
+bool ModelToScene(Model const &model, Scene &scene);
+bool SceneToModel(Scene const &scene, Model &model);
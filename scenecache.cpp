@@ -0,0 +1,227 @@
+#include "scenecache.h"
+#include "mappedfile.h"
+#include "hash.h"
+#include <Windows.h>
+#include <atomic>
+#include <fstream>
+
+using namespace rx3utils;
+
+namespace {
+
+char const SCENE_MAGIC[8] = { 'R', 'X', '3', 'S', 'C', 'N', '0', '3' };
+
+struct Span {
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct SceneHeader {
+    char magic[8];
+    uint32_t numMeshes;
+    uint32_t numBones;
+    uint64_t meshesOffset;
+    uint64_t bonesOffset;
+};
+
+struct BoneRecord {
+    Span name;
+    int32_t parent;
+    float transform[16];
+    float inverseBind[16];
+    uint32_t padding;
+};
+
+struct MeshRecord {
+    Span name;
+    Span material;
+    Span positions;
+    Span normals;
+    Span uvSets;  // Span records
+    Span colorSets;  // Span records
+    uint32_t numInfluences;
+    uint32_t padding;
+    Span joints;
+    Span weights;
+    Span indices;
+    Span morphs;  // MorphRecord records
+};
+
+struct MorphRecord {
+    Span name;
+    Span positions;
+    Span normals;
+};
+
+class SceneWriter {
+public:
+    vector<uint8_t> mData;
+
+    template<typename T> Span Add(T const *items, size_t count) {
+        mData.resize((mData.size() + 7) & ~size_t(7));
+        Span span = { mData.size(), count };
+        if (count)
+            mData.insert(mData.end(), reinterpret_cast<uint8_t const *>(items), reinterpret_cast<uint8_t const *>(items + count));
+        return span;
+    }
+    template<typename T> Span Add(vector<T> const &items) { return Add(items.data(), items.size()); }
+    Span Add(string const &str) { return Add(str.data(), str.size()); }
+};
+
+class SceneReader {
+    uint8_t const *mData;
+    size_t mSize;
+public:
+    SceneReader(uint8_t const *data, size_t size) : mData(data), mSize(size) {}
+
+    template<typename T> T const *Get(Span const &span) const {
+        if (span.offset > mSize || span.count > (mSize - span.offset) / sizeof(T))
+            return nullptr;
+        return reinterpret_cast<T const *>(mData + span.offset);
+    }
+    template<typename T> bool Read(Span const &span, vector<T> &out) const {
+        T const *items = Get<T>(span);
+        if (!items)
+            return false;
+        out.assign(items, items + span.count);
+        return true;
+    }
+    bool Read(Span const &span, string &out) const {
+        char const *chars = Get<char>(span);
+        if (!chars)
+            return false;
+        out.assign(chars, span.count);
+        return true;
+    }
+};
+
+}
+
+bool SaveSceneFile(Scene const &scene, path const &filePath) {
+    SceneWriter writer;
+    SceneHeader header = {};
+    memcpy(header.magic, SCENE_MAGIC, 8);
+    header.numMeshes = uint32_t(scene.meshes.size());
+    header.numBones = uint32_t(scene.bones.size());
+    writer.Add(&header, 1);
+    vector<BoneRecord> bones(scene.bones.size());
+    for (size_t b = 0; b < bones.size(); b++) {
+        bones[b] = {};
+        bones[b].name = writer.Add(scene.bones[b].name);
+        bones[b].parent = scene.bones[b].parent;
+        memcpy(bones[b].transform, scene.bones[b].transform.data(), sizeof(bones[b].transform));
+        memcpy(bones[b].inverseBind, scene.bones[b].inverseBind.data(), sizeof(bones[b].inverseBind));
+    }
+    vector<MeshRecord> meshes(scene.meshes.size());
+    for (size_t m = 0; m < meshes.size(); m++) {
+        auto const &mesh = scene.meshes[m];
+        auto &record = meshes[m];
+        record.name = writer.Add(mesh.name);
+        record.material = writer.Add(mesh.material);
+        record.positions = writer.Add(mesh.positions);
+        record.normals = writer.Add(mesh.normals);
+        vector<Span> uvSets;
+        for (auto const &uv : mesh.uvs)
+            uvSets.push_back(writer.Add(uv));
+        record.uvSets = writer.Add(uvSets);
+        vector<Span> colorSets;
+        for (auto const &colors : mesh.colors)
+            colorSets.push_back(writer.Add(colors));
+        record.colorSets = writer.Add(colorSets);
+        record.numInfluences = mesh.numInfluences;
+        record.joints = writer.Add(mesh.joints);
+        record.weights = writer.Add(mesh.weights);
+        record.indices = writer.Add(mesh.indices);
+        vector<MorphRecord> morphs;
+        for (auto const &morph : mesh.morphs)
+            morphs.push_back({ writer.Add(morph.name), writer.Add(morph.positions), writer.Add(morph.normals) });
+        record.morphs = writer.Add(morphs);
+    }
+    header.bonesOffset = writer.Add(bones).offset;
+    header.meshesOffset = writer.Add(meshes).offset;
+    memcpy(writer.mData.data(), &header, sizeof(header));
+    // written under a temporary name and renamed, a cache shared between jobs never has partial files
+    static std::atomic<uint32_t> counter = 0;
+    path tempPath = filePath;
+    tempPath += L".tmp" + to_wstring(GetCurrentProcessId()) + L"_" + to_wstring(counter++);
+    {
+        std::ofstream file(tempPath, std::ios::binary);
+        if (!file)
+            return false;
+        file.write(reinterpret_cast<char const *>(writer.mData.data()), writer.mData.size());
+        if (!file.good())
+            return false;
+    }
+    std::error_code ec;
+    rename(tempPath, filePath, ec);
+    return !ec;
+}
+
+bool LoadSceneFile(path const &filePath, Scene &scene) {
+    MappedFile file;
+    if (!file.Open(filePath) || file.Size() < sizeof(SceneHeader))
+        return false;
+    SceneReader reader(file.Data(), file.Size());
+    auto const *header = reinterpret_cast<SceneHeader const *>(file.Data());
+    if (memcmp(header->magic, SCENE_MAGIC, 8) != 0)
+        return false;
+    auto const *bones = reader.Get<BoneRecord>({ header->bonesOffset, header->numBones });
+    auto const *meshes = reader.Get<MeshRecord>({ header->meshesOffset, header->numMeshes });
+    if (!bones || !meshes)
+        return false;
+    scene = Scene();
+    scene.bones.resize(header->numBones);
+    for (uint32_t b = 0; b < header->numBones; b++) {
+        auto &bone = scene.bones[b];
+        if (!reader.Read(bones[b].name, bone.name))
+            return false;
+        bone.parent = bones[b].parent;
+        memcpy(bone.transform.data(), bones[b].transform, sizeof(bones[b].transform));
+        memcpy(bone.inverseBind.data(), bones[b].inverseBind, sizeof(bones[b].inverseBind));
+    }
+    scene.meshes.resize(header->numMeshes);
+    for (uint32_t m = 0; m < header->numMeshes; m++) {
+        auto const &record = meshes[m];
+        auto &mesh = scene.meshes[m];
+        vector<Span> uvSets, colorSets;
+        vector<MorphRecord> morphs;
+        if (!reader.Read(record.name, mesh.name) || !reader.Read(record.material, mesh.material) ||
+            !reader.Read(record.positions, mesh.positions) || !reader.Read(record.normals, mesh.normals) ||
+            !reader.Read(record.uvSets, uvSets) || !reader.Read(record.colorSets, colorSets) ||
+            !reader.Read(record.joints, mesh.joints) || !reader.Read(record.weights, mesh.weights) ||
+            !reader.Read(record.indices, mesh.indices) || !reader.Read(record.morphs, morphs))
+        {
+            return false;
+        }
+        mesh.uvs.resize(uvSets.size());
+        for (size_t s = 0; s < uvSets.size(); s++) {
+            if (!reader.Read(uvSets[s], mesh.uvs[s]))
+                return false;
+        }
+        mesh.colors.resize(colorSets.size());
+        for (size_t s = 0; s < colorSets.size(); s++) {
+            if (!reader.Read(colorSets[s], mesh.colors[s]))
+                return false;
+        }
+        mesh.numInfluences = record.numInfluences;
+        mesh.morphs.resize(morphs.size());
+        for (size_t t = 0; t < morphs.size(); t++) {
+            auto &morph = mesh.morphs[t];
+            if (!reader.Read(morphs[t].name, morph.name) || !reader.Read(morphs[t].positions, morph.positions) ||
+                !reader.Read(morphs[t].normals, morph.normals))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+path SceneCachePath(path const &folder, path const &source, uint64_t buildKey) {
+    MappedFile file;
+    if (!file.Open(source))
+        return path();
+    wchar_t name[17];
+    swprintf(name, 17, L"%016llx", (unsigned long long)Hash64(file.Data(), file.Size(), buildKey));
+    return folder / (wstring(name) + L".scene");
+}
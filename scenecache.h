@@ -0,0 +1,11 @@
+#pragma once
+#include "scene.h"
+
+// Binary snapshot of a Scene: a header, fixed-size bone/mesh/morph records and 8-byte aligned arrays
+// addressed by file offset, read straight from a file mapping. Used to cache parsed source models.
+bool SaveSceneFile(Scene const &scene, path const &filePath);
+bool LoadSceneFile(path const &filePath, Scene &scene);
+
+// <folder>/<xxHash64 of the source file contents, seeded with buildKey>.scene, empty if the source can't be read.
+// buildKey is BuildKey(RX3C_VERSION), a new build (ModelLibrary included) doesn't reuse older entries.
+path SceneCachePath(path const &folder, path const &source, uint64_t buildKey);
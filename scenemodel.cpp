@@ -0,0 +1,235 @@
+#include "scene.h"
+#include <cmath>
+
+using namespace rx3utils;
+
+using Matrix = SceneMatrix;
+
+// Matrix4x4 is row-major with row vectors, so its memory layout is the column-major layout of the
+// column-vector matrix used by Scene
+static Matrix ToSceneMatrix(Matrix4x4 const &m) {
+    Matrix result;
+    memcpy(result.data(), &m.m[0][0], sizeof(result));
+    return result;
+}
+
+static Matrix4x4 FromSceneMatrix(Matrix const &m) {
+    Matrix4x4 result;
+    memcpy(&result.m[0][0], m.data(), sizeof(m));
+    return result;
+}
+
+Matrix MultiplySceneMatrices(Matrix const &a, Matrix const &b) {
+    Matrix result = {};
+    for (int c = 0; c < 4; c++) {
+        for (int r = 0; r < 4; r++) {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; k++)
+                sum += a[k * 4 + r] * b[c * 4 + k];
+            result[c * 4 + r] = sum;
+        }
+    }
+    return result;
+}
+
+// Gauss-Jordan elimination
+Matrix InvertSceneMatrix(Matrix const &m) {
+    double a[4][8];
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 4; c++) {
+            a[r][c] = m[c * 4 + r];
+            a[r][c + 4] = r == c ? 1.0 : 0.0;
+        }
+    }
+    for (int c = 0; c < 4; c++) {
+        int pivot = c;
+        for (int r = c + 1; r < 4; r++) {
+            if (std::abs(a[r][c]) > std::abs(a[pivot][c]))
+                pivot = r;
+        }
+        if (std::abs(a[pivot][c]) < 1e-12)
+            return Matrix{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+        std::swap(a[c], a[pivot]);
+        double scale = 1.0 / a[c][c];
+        for (int k = 0; k < 8; k++)
+            a[c][k] *= scale;
+        for (int r = 0; r < 4; r++) {
+            if (r != c) {
+                double f = a[r][c];
+                for (int k = 0; k < 8; k++)
+                    a[r][k] -= f * a[c][k];
+            }
+        }
+    }
+    Matrix result;
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 4; c++)
+            result[c * 4 + r] = float(a[r][c + 4]);
+    }
+    return result;
+}
+
+// state: 0 not visited, 1 on the current parent chain, 2 done
+static void ResolveBoneParent(vector<SceneBone> const &bones, size_t b, vector<int32_t> &parents, vector<uint8_t> &state) {
+    if (state[b] == 2)
+        return;
+    state[b] = 1;
+    int32_t parent = bones[b].parent;
+    bool hasParent = parent >= 0 && size_t(parent) < bones.size() && state[parent] != 1;
+    if (hasParent)
+        ResolveBoneParent(bones, parent, parents, state);
+    parents[b] = hasParent ? parent : -1;
+    state[b] = 2;
+}
+
+vector<int32_t> SceneBoneParents(vector<SceneBone> const &bones) {
+    vector<int32_t> parents(bones.size(), -1);
+    vector<uint8_t> state(bones.size(), 0);
+    for (size_t b = 0; b < bones.size(); b++)
+        ResolveBoneParent(bones, b, parents, state);
+    return parents;
+}
+
+static Matrix const &GlobalBoneMatrix(vector<SceneBone> const &bones, vector<int32_t> const &parents, size_t b, vector<Matrix> &globals,
+    vector<bool> &done)
+{
+    if (!done[b]) {
+        globals[b] = parents[b] >= 0 ?
+            MultiplySceneMatrices(GlobalBoneMatrix(bones, parents, parents[b], globals, done), bones[b].transform) : bones[b].transform;
+        done[b] = true;
+    }
+    return globals[b];
+}
+
+vector<Matrix> GlobalBoneMatrices(vector<SceneBone> const &bones) {
+    auto parents = SceneBoneParents(bones);
+    vector<Matrix> globals(bones.size());
+    vector<bool> done(bones.size(), false);
+    for (size_t b = 0; b < bones.size(); b++)
+        GlobalBoneMatrix(bones, parents, b, globals, done);
+    return globals;
+}
+
+bool ModelToScene(Model const &model, Scene &scene) {
+    scene = Scene();
+    auto const &bones = model.skeleton.bones;
+    for (size_t b = 0; b < bones.size(); b++) {
+        SceneBone &bone = scene.bones.emplace_back();
+        bone.name = bones[b].name;
+        bone.parent = bones[b].parent;
+        bone.transform = ToSceneMatrix(bones[b].transform);
+    }
+    auto globals = GlobalBoneMatrices(scene.bones);
+    for (size_t b = 0; b < bones.size(); b++)
+        scene.bones[b].inverseBind = InvertSceneMatrix(globals[b]);
+    for (auto const &object : model.objects) {
+        SceneMesh &mesh = scene.meshes.emplace_back();
+        mesh.name = object.name;
+        mesh.material = object.material;
+        size_t numVertices = object.vertices.size();
+        size_t numUvSets = 0, numColorSets = 0, numInfluences = 0;
+        for (auto const &v : object.vertices) {
+            numUvSets = max(numUvSets, v.uv.size());
+            numColorSets = max(numColorSets, v.colors.size());
+            numInfluences = max(numInfluences, v.weights.size());
+        }
+        mesh.positions.resize(numVertices * 3);
+        mesh.normals.resize(numVertices * 3);
+        mesh.uvs.assign(numUvSets, vector<float>(numVertices * 2));
+        mesh.colors.assign(numColorSets, vector<uint8_t>(numVertices * 4));
+        mesh.numInfluences = uint32_t(numInfluences);
+        mesh.joints.assign(numVertices * numInfluences, SCENE_NO_JOINT);
+        mesh.weights.resize(numVertices * numInfluences);
+        for (size_t i = 0; i < numVertices; i++) {
+            auto const &v = object.vertices[i];
+            memcpy(&mesh.positions[i * 3], &v.pos, sizeof(float) * 3);
+            memcpy(&mesh.normals[i * 3], &v.normal, sizeof(float) * 3);
+            for (size_t s = 0; s < v.uv.size(); s++) {
+                mesh.uvs[s][i * 2] = v.uv[s].x;
+                mesh.uvs[s][i * 2 + 1] = v.uv[s].y;
+            }
+            for (size_t s = 0; s < v.colors.size(); s++) {
+                uint8_t rgba[4] = { v.colors[s].r, v.colors[s].g, v.colors[s].b, v.colors[s].a };
+                memcpy(&mesh.colors[s][i * 4], rgba, 4);
+            }
+            // influences keep their order and are not renormalized
+            for (size_t w = 0; w < v.weights.size(); w++) {
+                mesh.joints[i * numInfluences + w] = uint16_t(v.weights[w].bone);
+                mesh.weights[i * numInfluences + w] = v.weights[w].weight;
+            }
+        }
+        mesh.indices = object.indices;
+        for (auto const &key : object.shapeKeys) {
+            if (key.positions.size() != numVertices)
+                continue;
+            SceneMorph &morph = mesh.morphs.emplace_back();
+            morph.name = key.name;
+            morph.positions.resize(numVertices * 3);
+            memcpy(morph.positions.data(), key.positions.data(), sizeof(float) * 3 * numVertices);
+            if (key.normals.size() == numVertices) {
+                morph.normals.resize(numVertices * 3);
+                memcpy(morph.normals.data(), key.normals.data(), sizeof(float) * 3 * numVertices);
+            }
+        }
+    }
+    return true;
+}
+
+bool SceneToModel(Scene const &scene, Model &model) {
+    model = Model();
+    for (auto const &sceneBone : scene.bones) {
+        Bone &bone = model.skeleton.bones.emplace_back();
+        bone.name = sceneBone.name;
+        bone.parent = sceneBone.parent;
+        bone.transform = FromSceneMatrix(sceneBone.transform);
+    }
+    for (auto const &mesh : scene.meshes) {
+        size_t numVertices = mesh.NumVertices();
+        size_t numInfluences = mesh.numInfluences;
+        if ((!mesh.normals.empty() && mesh.normals.size() != numVertices * 3) ||
+            mesh.joints.size() != numVertices * numInfluences || mesh.weights.size() != numVertices * numInfluences)
+        {
+            return false;
+        }
+        for (auto const &uv : mesh.uvs) {
+            if (uv.size() != numVertices * 2)
+                return false;
+        }
+        for (auto const &colors : mesh.colors) {
+            if (colors.size() != numVertices * 4)
+                return false;
+        }
+        auto &object = model.objects.emplace_back();
+        object.name = mesh.name;
+        object.material = mesh.material;
+        object.vertices.resize(numVertices);
+        for (size_t i = 0; i < numVertices; i++) {
+            auto &v = object.vertices[i];
+            memcpy(&v.pos, &mesh.positions[i * 3], sizeof(float) * 3);
+            if (!mesh.normals.empty())
+                memcpy(&v.normal, &mesh.normals[i * 3], sizeof(float) * 3);
+            for (auto const &uv : mesh.uvs)
+                v.uv.push_back({ uv[i * 2], uv[i * 2 + 1] });
+            for (auto const &colors : mesh.colors)
+                v.colors.push_back({ colors[i * 4], colors[i * 4 + 1], colors[i * 4 + 2], colors[i * 4 + 3] });
+            for (size_t w = 0; w < numInfluences; w++) {
+                if (mesh.joints[i * numInfluences + w] != SCENE_NO_JOINT)
+                    v.weights.push_back({ int(mesh.joints[i * numInfluences + w]), mesh.weights[i * numInfluences + w] });
+            }
+        }
+        object.indices = mesh.indices;
+        for (auto const &morph : mesh.morphs) {
+            if (morph.positions.size() != numVertices * 3 || (!morph.normals.empty() && morph.normals.size() != numVertices * 3))
+                return false;
+            auto &key = object.shapeKeys.emplace_back();
+            key.name = morph.name;
+            key.positions.resize(numVertices);
+            memcpy(key.positions.data(), morph.positions.data(), sizeof(float) * 3 * numVertices);
+            if (!morph.normals.empty()) {
+                key.normals.resize(numVertices);
+                memcpy(key.normals.data(), morph.normals.data(), sizeof(float) * 3 * numVertices);
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,15 @@
+#include "tempfolder.h"
+#include <Windows.h>
+#include <atomic>
+
+TempFolder::TempFolder() {
+    static std::atomic<unsigned int> counter = 0;
+    mPath = temp_directory_path() / (L"rx3c_" + to_wstring(GetCurrentProcessId()) + L"_" + to_wstring(counter++));
+    std::error_code ec;
+    create_directories(mPath, ec);
+}
+
+TempFolder::~TempFolder() {
+    std::error_code ec;
+    remove_all(mPath, ec);
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include "Rx3Utils.h"
+
+// Unique folder under the system temp directory, removed with its contents on destruction
+class TempFolder {
+    path mPath;
+public:
+    TempFolder();
+    ~TempFolder();
+    TempFolder(TempFolder const &) = delete;
+    TempFolder &operator=(TempFolder const &) = delete;
+    path const &Path() const { return mPath; }
+};
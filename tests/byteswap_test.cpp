@@ -0,0 +1,66 @@
+#include "tests.h"
+#include "../byteswap.h"
+#include <bit>
+#include <cstring>
+#include <vector>
+
+// The SSE2/SSSE3 kernels against a per-word std::byteswap, for counts around the 16-byte block size and for
+// flat, tiled and mixed vertex layouts (including strides that don't divide 16).
+static std::vector<uint8_t> TestBytes(size_t size) {
+    std::vector<uint8_t> bytes(size);
+    for (size_t i = 0; i < size; i++)
+        bytes[i] = uint8_t(i * 37 + 11);
+    return bytes;
+}
+
+static void SwapWord(uint8_t *p, uint32_t size) {
+    if (size == 2) {
+        uint16_t w;
+        memcpy(&w, p, 2);
+        w = std::byteswap(w);
+        memcpy(p, &w, 2);
+    }
+    else {
+        uint32_t w;
+        memcpy(&w, p, 4);
+        w = std::byteswap(w);
+        memcpy(p, &w, 4);
+    }
+}
+
+bool TestByteSwap(std::filesystem::path const &) {
+    for (size_t count = 0; count < 40; count++) {
+        auto words16 = TestBytes(count * 2), expected16 = words16;
+        for (size_t i = 0; i < count; i++)
+            SwapWord(&expected16[i * 2], 2);
+        SwapBytes16(words16.data(), count);
+        if (words16 != expected16)
+            return TestFailed("byteswap", "SwapBytes16 differs for " + std::to_string(count) + " words");
+        auto words32 = TestBytes(count * 4), expected32 = words32;
+        for (size_t i = 0; i < count; i++)
+            SwapWord(&expected32[i * 4], 4);
+        SwapBytes32(words32.data(), count);
+        if (words32 != expected32)
+            return TestFailed("byteswap", "SwapBytes32 differs for " + std::to_string(count) + " words");
+    }
+    SwapLayout layouts[] = {
+        { 12, { { 0, 4 }, { 4, 4 }, { 8, 4 } } },                       // float3, flat 32-bit swap
+        { 8, { { 0, 2 }, { 2, 2 }, { 4, 2 }, { 6, 2 } } },              // half4, flat 16-bit swap
+        { 20, { { 0, 4 }, { 4, 4 }, { 8, 4 }, { 12, 2 }, { 14, 2 }, { 16, 4 } } }, // mixed, period 80
+        { 24, { { 0, 4 }, { 4, 4 }, { 8, 4 }, { 16, 2 } } },            // gaps stay untouched
+        { 6, { { 0, 2 }, { 2, 4 } } }                                   // unaligned word, scalar path
+    };
+    for (size_t l = 0; l < std::size(layouts); l++) {
+        for (size_t count : { size_t(1), size_t(3), size_t(7), size_t(33) }) {
+            auto records = TestBytes(count * layouts[l].stride), expected = records;
+            for (size_t i = 0; i < count; i++) {
+                for (auto const &[offset, size] : layouts[l].words)
+                    SwapWord(&expected[i * layouts[l].stride + offset], size);
+            }
+            SwapBytesStrided(records.data(), count, layouts[l]);
+            if (records != expected)
+                return TestFailed("byteswap", "SwapBytesStrided differs for layout " + std::to_string(l) + ", " + std::to_string(count) + " records");
+        }
+    }
+    return true;
+}
@@ -0,0 +1,650 @@
+#include "tests.h"
+#include "../fbxwriter.h"
+#include "../tempfolder.h"
+#include "Rx3Model.h"
+#include "Rx3Morph.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <map>
+#include <string_view>
+
+// Parity of WriteFbx (-model fbxfast) with the FBX SDK export (-model fbx). rx3lib builds an rx3 from a test
+// scene, then the SDK writes the reference from it as ASCII FBX and WriteFbx writes the same rx3 the way rx3c
+// exports it. Both files are parsed into node trees and compared per polygon vertex (positions, normals, uv
+// sets, colors, skin weights by bone name, blend shape offsets in channel order) and per bone (parent, local
+// translation and scaling, cluster TransformLink, bind pose). Blend shapes come from a morph targets container
+// built on the simple mesh. Ids, property templates, shape normals and other SDK bookkeeping are not compared.
+
+namespace {
+
+struct FbxNode {
+    std::string name;
+    std::vector<std::string> strings; // object names without their class
+    std::vector<double> numbers;      // scalar properties and array contents, in order
+    std::vector<int64_t> integers;    // integer scalar properties (ids)
+    std::vector<FbxNode> children;
+
+    FbxNode const *Child(std::string_view childName) const {
+        for (auto const &child : children) {
+            if (child.name == childName)
+                return &child;
+        }
+        return nullptr;
+    }
+};
+
+std::string ObjectName(std::string const &value) {
+    size_t binarySeparator = value.find(std::string_view("\0\1", 2));
+    if (binarySeparator != std::string::npos)
+        return value.substr(0, binarySeparator);
+    size_t asciiSeparator = value.find("::");
+    return asciiSeparator != std::string::npos ? value.substr(asciiSeparator + 2) : value;
+}
+
+// binary FBX, 32-bit node records up to 7400 and 64-bit ones from 7500; compressed arrays are not supported
+class FbxBinaryParser {
+    std::string const &mData;
+    bool mWide = false;
+
+    template<typename T> bool Get(size_t &pos, T &value) const {
+        if (pos + sizeof(T) > mData.size())
+            return false;
+        memcpy(&value, mData.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool GetOffset(size_t &pos, uint64_t &value) const {
+        uint32_t narrow = 0;
+        if (mWide)
+            return Get(pos, value);
+        if (!Get(pos, narrow))
+            return false;
+        value = narrow;
+        return true;
+    }
+
+    template<typename T> bool GetArray(size_t &pos, FbxNode &node) const {
+        uint32_t count = 0, encoding = 0, size = 0;
+        if (!Get(pos, count) || !Get(pos, encoding) || !Get(pos, size) || encoding != 0 || size != count * sizeof(T))
+            return false;
+        for (uint32_t i = 0; i < count; i++) {
+            T value;
+            if (!Get(pos, value))
+                return false;
+            node.numbers.push_back(double(value));
+        }
+        return true;
+    }
+
+    bool GetProperty(size_t &pos, FbxNode &node) const {
+        char type = 0;
+        if (!Get(pos, type))
+            return false;
+        switch (type) {
+        case 'C': { uint8_t v; if (!Get(pos, v)) return false; node.numbers.push_back(v); node.integers.push_back(v); return true; }
+        case 'Y': { int16_t v; if (!Get(pos, v)) return false; node.numbers.push_back(v); node.integers.push_back(v); return true; }
+        case 'I': { int32_t v; if (!Get(pos, v)) return false; node.numbers.push_back(v); node.integers.push_back(v); return true; }
+        case 'L': { int64_t v; if (!Get(pos, v)) return false; node.numbers.push_back(double(v)); node.integers.push_back(v); return true; }
+        case 'F': { float v; if (!Get(pos, v)) return false; node.numbers.push_back(v); return true; }
+        case 'D': { double v; if (!Get(pos, v)) return false; node.numbers.push_back(v); return true; }
+        case 'b': return GetArray<uint8_t>(pos, node);
+        case 'i': return GetArray<int32_t>(pos, node);
+        case 'l': return GetArray<int64_t>(pos, node);
+        case 'f': return GetArray<float>(pos, node);
+        case 'd': return GetArray<double>(pos, node);
+        case 'S':
+        case 'R': {
+            uint32_t size = 0;
+            if (!Get(pos, size) || pos + size > mData.size())
+                return false;
+            if (type == 'S')
+                node.strings.push_back(ObjectName(mData.substr(pos, size)));
+            pos += size;
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+public:
+    FbxBinaryParser(std::string const &data) : mData(data) {}
+
+    // null records end child lists
+    bool ParseNode(size_t &pos, FbxNode &node, bool &isNull) const {
+        uint64_t end = 0, numProperties = 0, propertiesSize = 0;
+        uint8_t nameSize = 0;
+        if (!GetOffset(pos, end) || !GetOffset(pos, numProperties) || !GetOffset(pos, propertiesSize) || !Get(pos, nameSize))
+            return false;
+        isNull = end == 0;
+        if (isNull)
+            return true;
+        if (end > mData.size() || pos + nameSize > end)
+            return false;
+        node.name = mData.substr(pos, nameSize);
+        pos += nameSize;
+        for (uint64_t p = 0; p < numProperties; p++) {
+            if (!GetProperty(pos, node))
+                return false;
+        }
+        while (pos < end) {
+            FbxNode child;
+            bool childIsNull = false;
+            if (!ParseNode(pos, child, childIsNull))
+                return false;
+            if (childIsNull)
+                break;
+            node.children.push_back(std::move(child));
+        }
+        pos = size_t(end);
+        return true;
+    }
+
+    bool Parse(FbxNode &root) {
+        uint32_t version = 0;
+        size_t pos = 23;
+        if (!Get(pos, version))
+            return false;
+        mWide = version >= 7500;
+        while (pos < mData.size()) {
+            FbxNode node;
+            bool isNull = false;
+            if (!ParseNode(pos, node, isNull))
+                return false;
+            if (isNull)
+                break;
+            root.children.push_back(std::move(node));
+        }
+        return true;
+    }
+};
+
+// ASCII FBX: "Name: value, value {", arrays as "Name: *count { a: values }"
+class FbxAsciiParser {
+    std::string const &mData;
+    size_t mPos = 0;
+
+    void SkipSpaces(bool newlines) {
+        while (mPos < mData.size()) {
+            char c = mData[mPos];
+            if (c == ';') {
+                while (mPos < mData.size() && mData[mPos] != '\n')
+                    mPos++;
+            }
+            else if (c == ' ' || c == '\t' || c == '\r' || (newlines && c == '\n'))
+                mPos++;
+            else
+                break;
+        }
+    }
+
+    // unquoted words (T, Y, ...) are kept as strings
+    static void AddValue(std::string_view token, FbxNode &node) {
+        double number = 0.0;
+        auto result = std::from_chars(token.data(), token.data() + token.size(), number);
+        if (result.ec != std::errc() || result.ptr != token.data() + token.size()) {
+            node.strings.emplace_back(token);
+            return;
+        }
+        node.numbers.push_back(number);
+        int64_t integer = 0;
+        auto integerResult = std::from_chars(token.data(), token.data() + token.size(), integer);
+        if (integerResult.ec == std::errc() && integerResult.ptr == token.data() + token.size())
+            node.integers.push_back(integer);
+    }
+
+    bool ParseChildren(FbxNode &parent) {
+        while (true) {
+            SkipSpaces(true);
+            if (mPos >= mData.size())
+                return true;
+            if (mData[mPos] == '}') {
+                mPos++;
+                return true;
+            }
+            size_t colon = mData.find(':', mPos);
+            if (colon == std::string::npos)
+                return false;
+            FbxNode node;
+            node.name = mData.substr(mPos, colon - mPos);
+            mPos = colon + 1;
+            bool isArray = false, afterComma = false;
+            while (true) {
+                SkipSpaces(afterComma);
+                afterComma = false;
+                if (mPos >= mData.size() || mData[mPos] == '\n')
+                    break;
+                char c = mData[mPos];
+                if (c == '{') {
+                    mPos++;
+                    if (!ParseChildren(node))
+                        return false;
+                    break;
+                }
+                if (c == ',') {
+                    mPos++;
+                    afterComma = true;
+                }
+                else if (c == '*') {
+                    isArray = true;
+                    while (mPos < mData.size() && mData[mPos] != ' ' && mData[mPos] != '{')
+                        mPos++;
+                }
+                else if (c == '"') {
+                    size_t close = mData.find('"', mPos + 1);
+                    if (close == std::string::npos)
+                        return false;
+                    node.strings.push_back(ObjectName(mData.substr(mPos + 1, close - mPos - 1)));
+                    mPos = close + 1;
+                }
+                else {
+                    size_t start = mPos;
+                    while (mPos < mData.size() && !strchr(",{} \t\r\n", mData[mPos]))
+                        mPos++;
+                    AddValue(std::string_view(mData).substr(start, mPos - start), node);
+                }
+            }
+            if (isArray && node.children.size() == 1 && node.children[0].name == "a") {
+                node.numbers = std::move(node.children[0].numbers);
+                node.children.clear();
+            }
+            parent.children.push_back(std::move(node));
+        }
+    }
+
+public:
+    FbxAsciiParser(std::string const &data) : mData(data) {}
+
+    bool Parse(FbxNode &root) {
+        return ParseChildren(root);
+    }
+};
+
+struct FbxMeshData {
+    std::vector<size_t> polygonSizes;
+    std::vector<double> positions; // per polygon vertex from here on
+    std::vector<double> normals;
+    std::vector<std::vector<double>> uvs;
+    std::vector<std::vector<double>> colors;
+    std::vector<std::map<std::string, double>> weights; // bone name -> weight
+    std::vector<std::vector<double>> shapes;             // position offsets per blend shape channel
+};
+
+struct FbxSceneData {
+    std::map<std::string, FbxMeshData> meshes;                 // by model name
+    std::map<std::string, std::string> boneParents;            // limb node -> parent model, empty for roots
+    std::map<std::string, std::vector<double>> boneLocals;     // translation and scaling
+    std::map<std::string, std::vector<double>> transformLinks; // by bone name
+    std::map<std::string, std::vector<double>> bindPose;       // by node name
+};
+
+// values of a layer element per polygon vertex
+bool ExpandLayer(FbxNode const &element, char const *valuesName, char const *indexName, size_t numComponents,
+    std::vector<int32_t> const &controlPoints, std::vector<double> &out)
+{
+    FbxNode const *values = element.Child(valuesName);
+    FbxNode const *mapping = element.Child("MappingInformationType");
+    FbxNode const *reference = element.Child("ReferenceInformationType");
+    if (!values || !mapping || mapping->strings.empty())
+        return false;
+    FbxNode const *indexes = (reference && !reference->strings.empty() && reference->strings[0] == "IndexToDirect") ? element.Child(indexName) : nullptr;
+    std::string const &mode = mapping->strings[0];
+    for (size_t pv = 0; pv < controlPoints.size(); pv++) {
+        size_t item = (mode == "ByVertice" || mode == "ByVertex") ? size_t(controlPoints[pv]) : (mode == "AllSame" ? 0 : pv);
+        if (indexes) {
+            if (item >= indexes->numbers.size())
+                return false;
+            item = size_t(indexes->numbers[item]);
+        }
+        if ((item + 1) * numComponents > values->numbers.size())
+            return false;
+        out.insert(out.end(), values->numbers.begin() + item * numComponents, values->numbers.begin() + (item + 1) * numComponents);
+    }
+    return true;
+}
+
+bool ReadFbxScene(std::filesystem::path const &filePath, FbxSceneData &scene, std::string &error) {
+    std::string data;
+    if (!ReadTestFile(filePath, data)) {
+        error = "unable to read " + filePath.filename().string();
+        return false;
+    }
+    FbxNode root;
+    bool parsed = data.starts_with("Kaydara FBX Binary") ? FbxBinaryParser(data).Parse(root) : FbxAsciiParser(data).Parse(root);
+    FbxNode const *objects = root.Child("Objects"), *connectionList = root.Child("Connections");
+    if (!parsed || !objects || !connectionList) {
+        error = "unable to parse " + filePath.filename().string();
+        return false;
+    }
+    std::map<int64_t, FbxNode const *> objectsById;
+    for (auto const &object : objects->children) {
+        if (!object.integers.empty() && !object.strings.empty())
+            objectsById[object.integers[0]] = &object;
+    }
+    std::vector<std::pair<int64_t, int64_t>> connections; // child, parent
+    for (auto const &c : connectionList->children) {
+        if (c.name == "C" && !c.strings.empty() && c.strings[0] == "OO" && c.integers.size() >= 2)
+            connections.emplace_back(c.integers[0], c.integers[1]);
+    }
+    auto Find = [&](int64_t id, bool parents, char const *nodeName) {
+        std::vector<FbxNode const *> found;
+        for (auto const &[child, parent] : connections) {
+            auto it = objectsById.find(parents ? (child == id ? parent : -1) : (parent == id ? child : -1));
+            if (it != objectsById.end() && it->second->name == nodeName)
+                found.push_back(it->second);
+        }
+        return found;
+    };
+    auto Subclass = [](FbxNode const *object) { return object->strings.size() > 1 ? object->strings.back() : std::string(); };
+    for (auto const &object : objects->children) {
+        if (object.name != "Model" || object.integers.empty() || object.strings.empty())
+            continue;
+        std::string const &name = object.strings[0];
+        if (Subclass(&object) == "LimbNode") {
+            auto parents = Find(object.integers[0], true, "Model");
+            scene.boneParents[name] = parents.empty() ? std::string() : parents[0]->strings[0];
+            std::vector<double> local = { 0, 0, 0, 1, 1, 1 };
+            if (FbxNode const *properties = object.Child("Properties70")) {
+                for (auto const &p : properties->children) {
+                    size_t offset = p.strings.empty() ? 2 : (p.strings[0] == "Lcl Translation" ? 0 : (p.strings[0] == "Lcl Scaling" ? 3 : 2));
+                    if (offset != 2 && p.numbers.size() >= 3)
+                        std::copy(p.numbers.end() - 3, p.numbers.end(), local.begin() + offset);
+                }
+            }
+            scene.boneLocals[name] = local;
+        }
+        if (Subclass(&object) != "Mesh")
+            continue;
+        auto geometries = Find(object.integers[0], false, "Geometry");
+        if (geometries.size() != 1) {
+            error = "mesh " + name + " has " + std::to_string(geometries.size()) + " geometries";
+            return false;
+        }
+        FbxNode const &geometry = *geometries[0];
+        FbxNode const *vertices = geometry.Child("Vertices"), *polygons = geometry.Child("PolygonVertexIndex");
+        if (!vertices || !polygons) {
+            error = "mesh " + name + " has no vertices or polygons";
+            return false;
+        }
+        FbxMeshData &mesh = scene.meshes[name];
+        std::vector<int32_t> controlPoints;
+        size_t polygonSize = 0;
+        for (double value : polygons->numbers) {
+            int32_t index = int32_t(value);
+            polygonSize++;
+            if (index < 0) {
+                index = ~index;
+                mesh.polygonSizes.push_back(polygonSize);
+                polygonSize = 0;
+            }
+            if (size_t(index) * 3 + 3 > vertices->numbers.size()) {
+                error = "mesh " + name + " has an invalid polygon vertex index";
+                return false;
+            }
+            controlPoints.push_back(index);
+            mesh.positions.insert(mesh.positions.end(), vertices->numbers.begin() + index * 3, vertices->numbers.begin() + index * 3 + 3);
+        }
+        for (auto const &element : geometry.children) {
+            bool expanded = true;
+            if (element.name == "LayerElementNormal" && mesh.normals.empty())
+                expanded = ExpandLayer(element, "Normals", "NormalsIndex", 3, controlPoints, mesh.normals);
+            else if (element.name == "LayerElementUV")
+                expanded = ExpandLayer(element, "UV", "UVIndex", 2, controlPoints, mesh.uvs.emplace_back());
+            else if (element.name == "LayerElementColor")
+                expanded = ExpandLayer(element, "Colors", "ColorIndex", 4, controlPoints, mesh.colors.emplace_back());
+            if (!expanded) {
+                error = "mesh " + name + " has an invalid " + element.name;
+                return false;
+            }
+        }
+        std::vector<std::map<std::string, double>> controlPointWeights(vertices->numbers.size() / 3);
+        for (FbxNode const *skin : Find(geometry.integers[0], false, "Deformer")) {
+            for (FbxNode const *cluster : Find(skin->integers[0], false, "Deformer")) {
+                auto bones = Find(cluster->integers[0], false, "Model");
+                FbxNode const *indexes = cluster->Child("Indexes"), *weights = cluster->Child("Weights");
+                if (bones.size() != 1)
+                    continue;
+                std::string const &bone = bones[0]->strings[0];
+                if (FbxNode const *link = cluster->Child("TransformLink"))
+                    scene.transformLinks[bone] = link->numbers;
+                for (size_t i = 0; indexes && weights && i < indexes->numbers.size() && i < weights->numbers.size(); i++) {
+                    size_t controlPoint = size_t(indexes->numbers[i]);
+                    if (controlPoint < controlPointWeights.size() && weights->numbers[i] != 0.0)
+                        controlPointWeights[controlPoint][bone] += weights->numbers[i];
+                }
+            }
+        }
+        for (int32_t controlPoint : controlPoints)
+            mesh.weights.push_back(controlPointWeights[controlPoint]);
+        for (FbxNode const *blendShape : Find(geometry.integers[0], false, "Deformer")) {
+            if (Subclass(blendShape) != "BlendShape")
+                continue;
+            for (FbxNode const *channel : Find(blendShape->integers[0], false, "Deformer")) {
+                std::vector<double> controlPointOffsets(vertices->numbers.size(), 0.0);
+                for (FbxNode const *shape : Find(channel->integers[0], false, "Geometry")) {
+                    FbxNode const *indexes = shape->Child("Indexes"), *offsets = shape->Child("Vertices");
+                    for (size_t i = 0; indexes && offsets && i < indexes->numbers.size() && i * 3 + 3 <= offsets->numbers.size(); i++) {
+                        size_t controlPoint = size_t(indexes->numbers[i]);
+                        for (size_t c = 0; c < 3 && controlPoint * 3 + c < controlPointOffsets.size(); c++)
+                            controlPointOffsets[controlPoint * 3 + c] += offsets->numbers[i * 3 + c];
+                    }
+                }
+                auto &offsets = mesh.shapes.emplace_back();
+                for (int32_t controlPoint : controlPoints)
+                    offsets.insert(offsets.end(), controlPointOffsets.begin() + controlPoint * 3, controlPointOffsets.begin() + controlPoint * 3 + 3);
+            }
+        }
+    }
+    for (auto const &object : objects->children) {
+        if (object.name != "Pose")
+            continue;
+        for (auto const &poseNode : object.children) {
+            FbxNode const *node = poseNode.Child("Node"), *matrix = poseNode.Child("Matrix");
+            if (poseNode.name != "PoseNode" || !node || !matrix || node->integers.empty())
+                continue;
+            auto it = objectsById.find(node->integers[0]);
+            if (it != objectsById.end())
+                scene.bindPose[it->second->strings[0]] = matrix->numbers;
+        }
+    }
+    return true;
+}
+
+bool Near(std::vector<double> const &a, std::vector<double> const &b, double tolerance) {
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (std::abs(a[i] - b[i]) > tolerance)
+            return false;
+    }
+    return true;
+}
+
+bool CompareFbxScenes(FbxSceneData const &sdk, FbxSceneData const &fast, std::string &error) {
+    if (sdk.meshes.size() != fast.meshes.size() || sdk.boneParents != fast.boneParents) {
+        error = "different meshes or bone hierarchy";
+        return false;
+    }
+    for (auto const &[name, expected] : sdk.meshes) {
+        auto it = fast.meshes.find(name);
+        if (it == fast.meshes.end()) {
+            error = "mesh " + name + " is missing";
+            return false;
+        }
+        FbxMeshData const &mesh = it->second;
+        char const *difference = nullptr;
+        if (mesh.polygonSizes != expected.polygonSizes)
+            difference = "polygons";
+        else if (!Near(mesh.positions, expected.positions, 1e-4))
+            difference = "positions";
+        else if (!Near(mesh.normals, expected.normals, 1e-3))
+            difference = "normals";
+        else if (mesh.uvs.size() != expected.uvs.size() || mesh.colors.size() != expected.colors.size())
+            difference = "number of uv or color sets";
+        else if (mesh.weights.size() != expected.weights.size())
+            difference = "skin weights";
+        else if (mesh.shapes.size() != expected.shapes.size())
+            difference = "number of blend shapes";
+        for (size_t s = 0; !difference && s < mesh.uvs.size(); s++)
+            difference = Near(mesh.uvs[s], expected.uvs[s], 1e-4) ? nullptr : "uvs";
+        for (size_t s = 0; !difference && s < mesh.colors.size(); s++)
+            difference = Near(mesh.colors[s], expected.colors[s], 1.0 / 255.0) ? nullptr : "colors";
+        for (size_t s = 0; !difference && s < mesh.shapes.size(); s++)
+            difference = Near(mesh.shapes[s], expected.shapes[s], 1e-4) ? nullptr : "blend shape offsets";
+        for (size_t pv = 0; !difference && pv < mesh.weights.size(); pv++) {
+            if (mesh.weights[pv].size() != expected.weights[pv].size())
+                difference = "skin weights";
+            for (auto const &[bone, weight] : expected.weights[pv]) {
+                auto w = mesh.weights[pv].find(bone);
+                if (w == mesh.weights[pv].end() || std::abs(w->second - weight) > 1e-4)
+                    difference = "skin weights";
+            }
+        }
+        if (difference) {
+            error = "mesh " + name + ": different " + difference;
+            return false;
+        }
+    }
+    for (auto const &[bone, local] : sdk.boneLocals) {
+        auto it = fast.boneLocals.find(bone);
+        if (it == fast.boneLocals.end() || !Near(it->second, local, 1e-4)) {
+            error = "bone " + bone + ": different local translation or scaling";
+            return false;
+        }
+    }
+    for (auto const &[bone, link] : sdk.transformLinks) {
+        auto it = fast.transformLinks.find(bone);
+        if (it == fast.transformLinks.end() || !Near(it->second, link, 1e-3)) {
+            error = "bone " + bone + ": different cluster TransformLink";
+            return false;
+        }
+    }
+    for (auto const &[node, matrix] : sdk.bindPose) {
+        auto it = fast.bindPose.find(node);
+        if (sdk.boneParents.contains(node) && (it == fast.bindPose.end() || !Near(it->second, matrix, 1e-3))) {
+            error = "bone " + node + ": different bind pose matrix";
+            return false;
+        }
+    }
+    return true;
+}
+
+// three bones, the second one rotated, and a quad with two uv sets, vertex colors and up to four influences
+Scene TestScene() {
+    Scene scene;
+    scene.bones.resize(3);
+    char const *boneNames[] = { "root", "neck", "head" };
+    for (size_t b = 0; b < 3; b++) {
+        scene.bones[b].name = boneNames[b];
+        scene.bones[b].parent = int32_t(b) - 1;
+        scene.bones[b].transform[13] = float(b) * 10.0f;
+    }
+    scene.bones[1].transform = { 0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1, 0, 0, 10, 0, 1 };
+    auto globals = GlobalBoneMatrices(scene.bones);
+    for (size_t b = 0; b < 3; b++)
+        scene.bones[b].inverseBind = InvertSceneMatrix(globals[b]);
+    SceneMesh &mesh = scene.meshes.emplace_back();
+    mesh.name = "head_0";
+    mesh.material = "skin";
+    mesh.positions = { 0, 0, 0, 10, 0, 0, 0, 20, 0, 10, 20, 5 };
+    mesh.normals = { 0, 0, 1, 0, 0, 1, 0, 0.6f, 0.8f, 0, 0.6f, 0.8f };
+    mesh.uvs = { { 0, 0, 1, 0, 0, 1, 1, 1 }, { 0.25f, 0.25f, 0.75f, 0.25f, 0.25f, 0.75f, 0.75f, 0.75f } };
+    mesh.colors = { { 255, 0, 0, 255, 0, 255, 0, 255, 0, 0, 255, 128, 255, 255, 255, 0 } };
+    mesh.numInfluences = 4;
+    uint16_t const none = SCENE_NO_JOINT;
+    mesh.joints = { 0, none, none, none, 0, 1, none, none, 0, 1, 2, none, 2, 1, 0, 0 };
+    mesh.weights = { 1, 0, 0, 0, 0.75f, 0.25f, 0, 0, 0.5f, 0.25f, 0.25f, 0, 0.5f, 0.25f, 0.125f, 0.125f };
+    mesh.indices = { 0, 1, 2, 2, 1, 3 };
+    return scene;
+}
+
+// the test quad with two morphs: one moves the top edge, one moves a single vertex and its normal
+Scene TestMorphScene() {
+    Scene scene = TestScene();
+    SceneMesh &mesh = scene.meshes[0];
+    SceneMorph &raise = mesh.morphs.emplace_back();
+    raise.name = "raise";
+    raise.positions = mesh.positions;
+    raise.positions[7] += 2.0f;
+    raise.positions[10] += 2.0f;
+    SceneMorph &push = mesh.morphs.emplace_back();
+    push.name = "push";
+    push.positions = mesh.positions;
+    push.positions[5] -= 1.5f;
+    push.normals = mesh.normals;
+    push.normals[3] = 0.6f;
+    push.normals[5] = 0.8f;
+    return scene;
+}
+
+// the FBX SDK reference, ASCII so that no array is compressed, and the WriteFbx export the way rx3c writes -model fbxfast
+bool ExportAndRead(std::filesystem::path const &rx3Path, std::filesystem::path const &folder, Rx3Options options, FbxSceneData &sdk,
+    FbxSceneData &fast, std::string &error)
+{
+    std::filesystem::path sdkFolder = folder / L"sdk";
+    std::filesystem::create_directories(sdkFolder);
+    options.modelFormat = "fbxascii";
+    {
+        Rx3Container rx3(rx3Path);
+        ExtractModelFromRX3(rx3, sdkFolder, options);
+    }
+    std::filesystem::path sdkPath;
+    for (auto const &entry : std::filesystem::directory_iterator(sdkFolder)) {
+        if (entry.path().extension() == L".fbx")
+            sdkPath = entry.path();
+    }
+    if (sdkPath.empty()) {
+        error = "the FBX SDK export of " + rx3Path.filename().string() + " wrote no file";
+        return false;
+    }
+    Scene scene;
+    std::filesystem::path fastPath = folder / L"fast.fbx";
+    if (!ModelToScene(ReadModelFromRX3(rx3Path, options), scene) || !WriteFbx(scene, fastPath)) {
+        error = "WriteFbx failed for " + rx3Path.filename().string();
+        return false;
+    }
+    return ReadFbxScene(sdkPath, sdk, error) && ReadFbxScene(fastPath, fast, error);
+}
+
+}
+
+bool TestFbx(std::filesystem::path const &) {
+    TempFolder temp;
+    Model model;
+    if (!SceneToModel(TestScene(), model))
+        return TestFailed("fbx", "invalid test scene");
+    Rx3Options options;
+    options.gameConfig = GameConfigs()[options.game];
+    options.metadata = false;
+    std::filesystem::path rx3Path = temp.Path() / L"fbx_test.rx3";
+    ModelToSimpleMeshContainer(model, L"fbx_test.fbx", rx3Path, options);
+    if (!std::filesystem::exists(rx3Path))
+        return TestFailed("fbx", "rx3lib didn't write the test rx3");
+    FbxSceneData sdk, fast;
+    std::string error;
+    if (!ExportAndRead(rx3Path, temp.Path() / L"simple", options, sdk, fast, error))
+        return TestFailed("fbx", error);
+    if (sdk.meshes.empty() || sdk.boneParents.empty())
+        return TestFailed("fbx", "the FBX SDK export has no mesh or no bones");
+    if (!CompareFbxScenes(sdk, fast, error))
+        return TestFailed("fbx", error);
+    // blend shapes, on top of the simple mesh as with -baseModel
+    Model morphModel;
+    if (!SceneToModel(TestMorphScene(), morphModel))
+        return TestFailed("fbx", "invalid morph test scene");
+    options.baseModel = ReadModelFromRX3(rx3Path, options);
+    std::filesystem::path morphPath = temp.Path() / L"fbx_test_morphtargets.rx3";
+    ModelToMorphTargetsContainer(morphModel, L"fbx_test_morphtargets.fbx", morphPath, options);
+    if (!std::filesystem::exists(morphPath))
+        return TestFailed("fbx", "rx3lib didn't write the morph targets rx3");
+    FbxSceneData sdkMorphs, fastMorphs;
+    if (!ExportAndRead(morphPath, temp.Path() / L"morphs", options, sdkMorphs, fastMorphs, error))
+        return TestFailed("fbx", error);
+    if (std::ranges::none_of(sdkMorphs.meshes, [](auto const &mesh) { return mesh.second.shapes.size() == 2; }))
+        return TestFailed("fbx", "the FBX SDK export has no mesh with both blend shapes");
+    if (!CompareFbxScenes(sdkMorphs, fastMorphs, error))
+        return TestFailed("fbx", error);
+    return true;
+}
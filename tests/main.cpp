@@ -0,0 +1,35 @@
+#include "tests.h"
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+bool ReadTestFile(std::filesystem::path const &filePath, std::string &out) {
+    std::ifstream f(filePath, std::ios::binary);
+    if (!f.is_open())
+        return false;
+    out.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    return true;
+}
+
+bool TestFailed(std::string const &test, std::string const &msg) {
+    std::cout << test << ": " << msg << '\n';
+    return false;
+}
+
+// rx3c_tests [dataFolder], returns the number of failed tests
+int main(int argc, char *argv[]) {
+    std::filesystem::path dataFolder = argc > 1 ? std::filesystem::path(argv[1]) : std::filesystem::path("data");
+    struct { char const *name; bool(*func)(std::filesystem::path const &); } tests[] = {
+        { "byteswap", TestByteSwap },
+        { "qoi", TestQoi },
+        { "fbx", TestFbx }
+    };
+    int failed = 0;
+    for (auto const &t : tests) {
+        bool passed = t.func(dataFolder);
+        std::cout << (passed ? "passed: " : "FAILED: ") << t.name << '\n';
+        if (!passed)
+            failed++;
+    }
+    return failed;
+}
@@ -0,0 +1,34 @@
+#include "tests.h"
+#include "../qoi.h"
+#include <cstring>
+
+// qoi_reference.qoi was written by the reference encoder (phoboslab/qoi) from the 16x8 pixels in
+// qoi_reference.rgba. The image starts with transparent black, which the reference encodes as
+// QOI_OP_INDEX 0 because the index starts zeroed, and covers runs over 62 pixels, DIFF, LUMA, RGB,
+// RGBA and index hits.
+bool TestQoi(std::filesystem::path const &dataFolder) {
+    static constexpr uint32_t width = 16, height = 8;
+    std::string pixels, reference;
+    if (!ReadTestFile(dataFolder / "qoi_reference.rgba", pixels) || !ReadTestFile(dataFolder / "qoi_reference.qoi", reference))
+        return TestFailed("qoi", "missing reference files");
+    if (pixels.size() != width * height * 4)
+        return TestFailed("qoi", "unexpected reference image size");
+    std::vector<uint8_t> encoded;
+    if (!EncodeQOI((uint8_t const *)pixels.data(), width, height, width * 4, encoded))
+        return TestFailed("qoi", "encoding failed");
+    if (encoded.size() != reference.size() || memcmp(encoded.data(), reference.data(), encoded.size()) != 0) {
+        size_t i = 0;
+        while (i < encoded.size() && i < reference.size() && encoded[i] == uint8_t(reference[i]))
+            i++;
+        return TestFailed("qoi", "encoded data differs from the reference at byte " + std::to_string(i));
+    }
+    uint32_t w = 0, h = 0;
+    if (!ReadQOIHeader((uint8_t const *)reference.data(), reference.size(), w, h) || w != width || h != height)
+        return TestFailed("qoi", "invalid reference header");
+    std::vector<uint8_t> decoded(pixels.size());
+    if (!DecodeQOI((uint8_t const *)reference.data(), reference.size(), decoded.data(), width, height, width * 4))
+        return TestFailed("qoi", "decoding failed");
+    if (memcmp(decoded.data(), pixels.data(), pixels.size()) != 0)
+        return TestFailed("qoi", "decoded pixels differ from the reference image");
+    return true;
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include <filesystem>
+#include <string>
+
+// each test prints what failed and returns false; dataFolder is tests/data
+bool TestByteSwap(std::filesystem::path const &dataFolder);
+bool TestQoi(std::filesystem::path const &dataFolder);
+bool TestFbx(std::filesystem::path const &dataFolder);
+
+bool ReadTestFile(std::filesystem::path const &filePath, std::string &out);
+bool TestFailed(std::string const &test, std::string const &msg);
@@ -0,0 +1,286 @@
+#include "texdedup.h"
+#include "textures.h"
+#include "tempfolder.h"
+#include "hash.h"
+#include "TextFileTable.h"
+#include <fstream>
+
+using namespace rx3utils;
+
+static path FindExportedTexture(path const &outDir, string const &name, Rx3Options const &options) {
+    vector<wstring> extensions = { L".png", L".dds", L".tga", L".hdr" };
+    if (!options.textureFormat.empty())
+        extensions.insert(extensions.begin(), L"." + AtoW(options.textureFormat));
+    for (auto const &ext : extensions) {
+        path p = outDir / (AtoW(name) + ext);
+        if (exists(p))
+            return p;
+    }
+    return path();
+}
+
+static void LinkTexture(path const &source, path const &target) {
+    std::error_code ec;
+    if (exists(target, ec))
+        remove(target, ec);
+    create_hard_link(source, target, ec);
+    if (ec)
+        copy_file(source, target, copy_options::overwrite_existing, ec);
+}
+
+namespace {
+
+// -writeTexMetadata table of an exported rx3: <rx3>_metadata.csv or <rx3>.csv, UTF-16 (with BOM) or 8-bit text,
+// one row per texture with the name as first field. Rows are handled as raw text in the file's encoding.
+class MetadataTable {
+    path mPath;
+    bool mUtf16 = false;
+    std::u16string mText16;
+    string mText8;
+
+    template<typename Char> static void ReadRows(std::basic_string<Char> const &text, map<string, string> &rows) {
+        for (size_t pos = 0; pos < text.size();) {
+            size_t end = min(text.find(Char('\n'), pos), text.size());
+            size_t lineEnd = (end > pos && text[end - 1] == Char('\r')) ? end - 1 : end;
+            size_t separator = pos;
+            while (separator < lineEnd && text[separator] != Char(',') && text[separator] != Char(';') && text[separator] != Char('\t'))
+                separator++;
+            if (separator < lineEnd) {
+                string name;
+                for (size_t i = pos; i < separator; i++)
+                    name += char(text[i] >= 'A' && text[i] <= 'Z' ? text[i] - 'A' + 'a' : text[i]);
+                rows.try_emplace(name, reinterpret_cast<char const *>(&text[separator]), (lineEnd - separator) * sizeof(Char));
+            }
+            pos = end + 1;
+        }
+    }
+
+    template<typename Char> static void AppendRow(std::basic_string<Char> &text, string const &name, string const &rest) {
+        bool crlf = text.find(Char('\r')) != std::basic_string<Char>::npos;
+        if (!text.empty() && text.back() != Char('\n')) {
+            if (crlf)
+                text += Char('\r');
+            text += Char('\n');
+        }
+        text.append(name.begin(), name.end());
+        text.append(reinterpret_cast<Char const *>(rest.data()), rest.size() / sizeof(Char));
+        if (crlf)
+            text += Char('\r');
+        text += Char('\n');
+    }
+public:
+    bool Open(path const &outDir, wstring const &rx3Name) {
+        mPath = outDir / (rx3Name + L"_metadata.csv");
+        if (!exists(mPath))
+            mPath = outDir / (rx3Name + L".csv");
+        std::ifstream in(mPath, std::ios::binary);
+        if (!in.is_open())
+            return false;
+        string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        mUtf16 = bytes.size() >= 2 && uint8_t(bytes[0]) == 0xFF && uint8_t(bytes[1]) == 0xFE;
+        if (mUtf16) {
+            mText16.resize((bytes.size() - 2) / 2);
+            memcpy(mText16.data(), bytes.data() + 2, mText16.size() * 2);
+        }
+        else
+            mText8 = std::move(bytes);
+        return true;
+    }
+
+    bool IsUtf16() const { return mUtf16; }
+
+    // lowered name -> rest of the line from the first separator, raw bytes in the file's encoding
+    map<string, string> Rows() const {
+        map<string, string> rows;
+        if (mUtf16)
+            ReadRows(mText16, rows);
+        else
+            ReadRows(mText8, rows);
+        return rows;
+    }
+
+    void Append(string const &name, string const &rest) {
+        if (mUtf16)
+            AppendRow(mText16, name, rest);
+        else
+            AppendRow(mText8, name, rest);
+    }
+
+    bool Save() const {
+        std::ofstream out(mPath, std::ios::binary);
+        if (mUtf16) {
+            out.write("\xFF\xFE", 2);
+            out.write(reinterpret_cast<char const *>(mText16.data()), mText16.size() * 2);
+        }
+        else
+            out.write(mText8.data(), mText8.size());
+        return out.good();
+    }
+};
+
+}
+
+void TextureDedup::ExtractTextures(Rx3Container &rx3, path const &rx3Path, path const &outDir, Rx3Options &options) {
+    Rx3File raw;
+    if (!raw.Open(rx3Path)) {
+        ExtractTexturesFromRX3(rx3, outDir, options);
+        return;
+    }
+    Rx3FileWriter unique(raw);
+    vector<pair<string, uint64_t>> kept, duplicates;
+    set<uint64_t> seen;
+    bool allNamed = true;
+    for (auto it = unique.mChunks.begin(); it != unique.mChunks.end(); ) {
+        if (it->type == RX3_CHUNK_TEXTURE) {
+            allNamed = allNamed && !it->name.empty();
+            uint64_t hash = Hash64(it->data.data(), it->data.size());
+            if (mExportedFiles.contains(hash) || seen.contains(hash)) {
+                duplicates.emplace_back(it->name, hash);
+                it = unique.mChunks.erase(it);
+                continue;
+            }
+            seen.insert(hash);
+            kept.emplace_back(it->name, hash);
+        }
+        ++it;
+    }
+    if (!allNamed || duplicates.empty())
+        ExtractTexturesFromRX3(rx3, outDir, options);
+    else if (!kept.empty()) {
+        unique.UpdateTextureBatchCount();
+        TempFolder temp;
+        path uniquePath = temp.Path() / rx3Path.filename();
+        if (unique.Save(uniquePath)) {
+            Rx3Container uniqueRx3(uniquePath);
+            ExtractTexturesFromRX3(uniqueRx3, outDir, options);
+        }
+    }
+    if (!allNamed)
+        return;
+    for (auto const &[name, hash] : kept) {
+        path file = FindExportedTexture(outDir, name, options);
+        if (!file.empty())
+            mExportedFiles[hash] = file;
+    }
+    for (auto const &[name, hash] : duplicates) {
+        auto it = mExportedFiles.find(hash);
+        if (it != mExportedFiles.end())
+            LinkTexture(it->second, outDir / (AtoW(name) + it->second.extension().wstring()));
+    }
+    // the metadata table only has rows for the extracted textures, duplicates get a copy of their original's row
+    MetadataTable table;
+    if (options.writeTexMetadata && table.Open(outDir, rx3Path.stem().wstring())) {
+        auto rows = table.Rows();
+        for (auto const &[name, hash] : kept) {
+            auto row = rows.find(ToLower(name));
+            if (row != rows.end())
+                mMetadataRows[hash] = { table.IsUtf16(), row->second };
+        }
+        bool changed = false;
+        for (auto const &[name, hash] : duplicates) {
+            auto row = mMetadataRows.find(hash);
+            if (row != mMetadataRows.end() && row->second.first == table.IsUtf16() && !rows.contains(ToLower(name))) {
+                table.Append(name, row->second.second);
+                changed = true;
+            }
+        }
+        if (changed)
+            table.Save();
+    }
+}
+
+TextureDedup::ImportPlan TextureDedup::PrepareImport(vector<path> const &inTextures, vector<string> const &formatPatterns, string const &target,
+    path const &metadataFile)
+{
+    ImportPlan plan;
+    set<uint64_t> keys;
+    // metadata rows (name first) are part of the key, textures with different metadata are encoded separately
+    map<string, string> metadataRows;
+    if (!metadataFile.empty() && exists(metadataFile)) {
+        TextFileTable table;
+        table.ReadUnicodeText(metadataFile);
+        for (auto const &r : table.Rows()) {
+            if (r.empty() || r[0].empty())
+                continue;
+            string row;
+            for (size_t i = 1; i < r.size(); i++)
+                row += ToUTF8(r[i]) + '\x1F';
+            metadataRows.try_emplace(ToLower(ToUTF8(r[0])), row);
+        }
+    }
+    for (auto const &tex : inTextures) {
+        plan.order.push_back(ToUTF8(tex.stem().c_str()));
+        auto hashIt = mPixelHashes.find(tex);
+        if (hashIt == mPixelHashes.end()) {
+            DirectX::ScratchImage image;
+            if (!LoadTextureFile(tex, image)) {
+                plan.toEncode.push_back(tex);
+                continue;
+            }
+            hashIt = mPixelHashes.emplace(tex, HashTexturePixels(image)).first;
+        }
+        ImportEntry entry;
+        entry.name = ToUTF8(tex.stem().c_str());
+        string pattern = FindTexturePattern(ToLower(entry.name), formatPatterns);
+        auto row = metadataRows.find(ToLower(entry.name));
+        string metadata = row != metadataRows.end() ? row->second : string();
+        entry.key = Hash64(pattern.data(), pattern.size(), Hash64(target.data(), target.size(), hashIt->second));
+        entry.key = Hash64(metadata.data(), metadata.size(), entry.key);
+        if (mEncodedChunks.contains(entry.key) || keys.contains(entry.key))
+            plan.reused.push_back(entry);
+        else {
+            keys.insert(entry.key);
+            plan.toEncode.push_back(tex);
+            plan.encoded.push_back(entry);
+        }
+    }
+    return plan;
+}
+
+void TextureDedup::FinishImport(path const &rx3Path, ImportPlan const &plan) {
+    Rx3File raw;
+    if (!raw.Open(rx3Path))
+        return;
+    map<string, Rx3FileChunk const *> textureChunks;
+    for (auto const *c : raw.FindChunks(RX3_CHUNK_TEXTURE))
+        textureChunks[ToLower(c->name)] = c;
+    for (auto const &entry : plan.encoded) {
+        auto it = textureChunks.find(ToLower(entry.name));
+        if (it != textureChunks.end())
+            mEncodedChunks[entry.key].assign(raw.ChunkData(*it->second), raw.ChunkData(*it->second) + it->second->size);
+    }
+    if (plan.reused.empty())
+        return;
+    Rx3FileWriter writer(raw);
+    // encoded and reused textures go back to the order of a regular import, at the place of the first texture
+    vector<Rx3FileWriter::Chunk> textures;
+    size_t insertIndex = writer.mChunks.size();
+    for (size_t i = 0; i < writer.mChunks.size(); i++) {
+        if (writer.mChunks[i].type == RX3_CHUNK_TEXTURE) {
+            insertIndex = min(insertIndex, i);
+            textures.push_back(std::move(writer.mChunks[i]));
+        }
+    }
+    std::erase_if(writer.mChunks, [](auto const &c) { return c.type == RX3_CHUNK_TEXTURE; });
+    for (auto const &entry : plan.reused) {
+        auto it = mEncodedChunks.find(entry.key);
+        if (it != mEncodedChunks.end()) {
+            auto &chunk = textures.emplace_back();
+            chunk.type = RX3_CHUNK_TEXTURE;
+            chunk.data = it->second;
+            chunk.name = entry.name;
+        }
+    }
+    map<string, size_t> position;
+    for (size_t i = 0; i < plan.order.size(); i++)
+        position.try_emplace(ToLower(plan.order[i]), i);
+    std::stable_sort(textures.begin(), textures.end(), [&](auto const &a, auto const &b) {
+        auto pa = position.find(ToLower(a.name)), pb = position.find(ToLower(b.name));
+        return (pa != position.end() ? pa->second : plan.order.size()) < (pb != position.end() ? pb->second : plan.order.size());
+    });
+    writer.mChunks.insert(writer.mChunks.begin() + min(insertIndex, writer.mChunks.size()),
+        std::make_move_iterator(textures.begin()), std::make_move_iterator(textures.end()));
+    writer.UpdateTextureBatchCount();
+    raw.Close();
+    writer.Save(rx3Path);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "rx3file.h"
+#include "Rx3Textures.h"
+
+// Opt-in texture deduplication (-dedup), shared across all rx3 files of one run.
+// Export: textures with identical TEXTURE chunks are decoded and written once, the copies are hard-linked
+// and get a copy of their original's -writeTexMetadata row.
+// Import: textures with identical source pixels (and the same texFormatFile pattern and metadata row) are
+// encoded once, the encoded TEXTURE chunk is reused for every other occurrence with the same target game.
+// Textures keep the order of a regular import.
+class TextureDedup {
+    map<uint64_t, path> mExportedFiles;
+    map<uint64_t, vector<uint8_t>> mEncodedChunks;
+    map<path, uint64_t> mPixelHashes;
+    map<uint64_t, pair<bool, string>> mMetadataRows; // -writeTexMetadata row after the name (UTF-16?, raw text)
+public:
+    struct ImportEntry {
+        string name;
+        uint64_t key = 0;
+    };
+    struct ImportPlan {
+        vector<string> order; // all texture names, as ImportTexturesToRX3 would write them
+        vector<path> toEncode;
+        vector<ImportEntry> encoded;
+        vector<ImportEntry> reused;
+    };
+
+    void ExtractTextures(Rx3Container &rx3, path const &rx3Path, path const &outDir, Rx3Options &options);
+    ImportPlan PrepareImport(vector<path> const &inTextures, vector<string> const &formatPatterns, string const &target,
+        path const &metadataFile);
+    void FinishImport(path const &rx3Path, ImportPlan const &plan);
+};
@@ -0,0 +1,331 @@
+#include "texprep.h"
+#include "textures.h"
+#include "TextFileTable.h"
+#include "qoi.h"
+#include "errormsg.h"
+#include <emmintrin.h>
+#include <fstream>
+
+using namespace rx3utils;
+using namespace DirectX;
+
+void TexturePrepSettings::ReadRules(path const &texFormatFile) {
+    if (!exists(texFormatFile))
+        return;
+    // optional third column of the texture format file: maximum texture size for the pattern
+    TextFileTable table;
+    table.ReadUnicodeText(texFormatFile);
+    for (auto const &r : table.Rows()) {
+        if (r.size() >= 2 && !r[0].empty() && !r[1].empty())
+            formatRules.emplace_back(ToLower(WtoA(r[0])), ToLower(WtoA(r[1])));
+        if (r.size() >= 3 && !r[0].empty()) {
+            int size = 0;
+            try { size = stoi(r[2]); }
+            catch (...) {}
+            if (size > 0)
+                maxSizeRules.emplace_back(ToLower(WtoA(r[0])), uint32_t(size));
+        }
+    }
+}
+
+uint32_t TexturePrepSettings::MaxSizeFor(string const &textureName) const {
+    for (auto const &[pattern, size] : maxSizeRules) {
+        if (MatchesWildcard(textureName, pattern))
+            return size;
+    }
+    return maxSize;
+}
+
+string TexturePrepSettings::FormatFor(string const &textureName) const {
+    for (auto const &[pattern, format] : formatRules) {
+        if (MatchesWildcard(textureName, pattern))
+            return format;
+    }
+    return string();
+}
+
+bool TexturePrepSettings::IsActive() const {
+    return maxSize != 0 || !maxSizeRules.empty() || !formatRules.empty() || autoFormat;
+}
+
+enum TextureClass {
+    TEX_CLASS_OPAQUE,
+    TEX_CLASS_ALPHA_1BIT,
+    TEX_CLASS_ALPHA_FULL
+};
+
+static char const *TextureClassName(TextureClass c) {
+    switch (c) {
+    case TEX_CLASS_ALPHA_1BIT: return "alpha1bit";
+    case TEX_CLASS_ALPHA_FULL: return "alpha";
+    }
+    return "opaque";
+}
+
+// one pass over 8-bit RGBA pixels: alpha range and non-binary alpha are tracked 4 pixels at a time. Grayscale and
+// normal maps are not told apart, the game configs don't say which games read BC4/L8 or BC5.
+static TextureClass ClassifyTexture(Image const &img) {
+    __m128i const alphaMask = _mm_set1_epi32(int(0xFF000000));
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const full = _mm_set1_epi8(-1);
+    __m128i minAlpha = full, maxAlpha = zero;
+    bool partialAlpha = false;
+    for (size_t y = 0; y < img.height; y++) {
+        uint8_t const *row = img.pixels + y * img.rowPitch;
+        size_t x = 0;
+        for (; x + 4 <= img.width; x += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(row + x * 4));
+            __m128i a = _mm_or_si128(_mm_and_si128(v, alphaMask), _mm_andnot_si128(alphaMask, full));
+            minAlpha = _mm_min_epu8(minAlpha, a);
+            maxAlpha = _mm_max_epu8(maxAlpha, _mm_and_si128(v, alphaMask));
+            __m128i binary = _mm_or_si128(_mm_cmpeq_epi8(v, zero), _mm_cmpeq_epi8(v, full));
+            if ((_mm_movemask_epi8(binary) & 0x8888) != 0x8888)
+                partialAlpha = true;
+        }
+        for (; x < img.width; x++) {
+            uint8_t const *px = row + x * 4;
+            minAlpha = _mm_min_epu8(minAlpha, _mm_set1_epi32(int(uint32_t(px[3]) << 24 | 0xFFFFFF)));
+            maxAlpha = _mm_max_epu8(maxAlpha, _mm_set1_epi32(int(uint32_t(px[3]) << 24)));
+            if (px[3] != 0 && px[3] != 255)
+                partialAlpha = true;
+        }
+    }
+    uint8_t minA[16], maxA[16];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(minA), minAlpha);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(maxA), maxAlpha);
+    uint8_t lowestAlpha = min(min(minA[3], minA[7]), min(minA[11], minA[15]));
+    uint8_t highestAlpha = max(max(maxA[3], maxA[7]), max(maxA[11], maxA[15]));
+    if (lowestAlpha < 255) {
+        if (partialAlpha || highestAlpha == 0)
+            return TEX_CLASS_ALPHA_FULL;
+        return TEX_CLASS_ALPHA_1BIT;
+    }
+    return TEX_CLASS_OPAQUE;
+}
+
+static bool EncodeAutoFormat(ScratchImage &image, path const &outPath, TextureFormatDecision &decision) {
+    if (image.GetMetadata().format != DXGI_FORMAT_R8G8B8A8_UNORM) {
+        ScratchImage rgba;
+        if (FAILED(Convert(*image.GetImage(0, 0, 0), DXGI_FORMAT_R8G8B8A8_UNORM, TEX_FILTER_DEFAULT, TEX_THRESHOLD_DEFAULT, rgba)))
+            return false;
+        image = std::move(rgba);
+    }
+    TextureClass textureClass = ClassifyTexture(*image.GetImage(0, 0, 0));
+    // 1-bit alpha fits DXT1's transparent block mode
+    DXGI_FORMAT format = textureClass == TEX_CLASS_ALPHA_FULL ? DXGI_FORMAT_BC3_UNORM : DXGI_FORMAT_BC1_UNORM;
+    ScratchImage mips, encoded;
+    if (FAILED(GenerateMipMaps(*image.GetImage(0, 0, 0), TEX_FILTER_BOX, 0, mips)))
+        return false;
+    if (FAILED(Compress(mips.GetImages(), mips.GetImageCount(), mips.GetMetadata(), format, TEX_COMPRESS_PARALLEL, TEX_THRESHOLD_DEFAULT, encoded)))
+        return false;
+    if (FAILED(SaveToDDSFile(encoded.GetImages(), encoded.GetImageCount(), encoded.GetMetadata(), DDS_FLAGS_NONE, outPath.c_str())))
+        return false;
+    decision.textureClass = TextureClassName(textureClass);
+    decision.format = format == DXGI_FORMAT_BC3_UNORM ? "dxt5" : "dxt1";
+    return true;
+}
+
+static bool ReadTextureMetadata(path const &filePath, TexMetadata &meta) {
+    wstring ext = ToLower(filePath.extension().wstring());
+    HRESULT hr;
+    if (ext == L".qoi") {
+        uint8_t header[22] = {};
+        std::ifstream file(filePath, std::ios::binary);
+        uint32_t width, height;
+        if (!file.read(reinterpret_cast<char *>(header), sizeof(header)) || !ReadQOIHeader(header, sizeof(header), width, height))
+            return false;
+        meta = {};
+        meta.width = width;
+        meta.height = height;
+        meta.depth = 1;
+        meta.arraySize = 1;
+        meta.mipLevels = 1;
+        meta.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        meta.dimension = TEX_DIMENSION_TEXTURE2D;
+        return true;
+    }
+    if (ext == L".dds")
+        hr = GetMetadataFromDDSFile(filePath.c_str(), DDS_FLAGS_NONE, meta);
+    else if (ext == L".hdr")
+        hr = GetMetadataFromHDRFile(filePath.c_str(), meta);
+    else if (ext == L".tga")
+        hr = GetMetadataFromTGAFile(filePath.c_str(), TGA_FLAGS_NONE, meta);
+    else
+        hr = GetMetadataFromWICFile(filePath.c_str(), WIC_FLAGS_NONE, meta);
+    return SUCCEEDED(hr);
+}
+
+static bool DownscaleDDS(ScratchImage &image, uint32_t maxSize) {
+    TexMetadata const srcMeta = image.GetMetadata();
+    // existing mip levels that already fit are kept as they are
+    for (size_t level = 1; level < srcMeta.mipLevels; level++) {
+        Image const *first = image.GetImage(level, 0, 0);
+        if (first->width <= maxSize && first->height <= maxSize) {
+            ScratchImage result;
+            if (FAILED(result.Initialize2D(srcMeta.format, first->width, first->height, 1, srcMeta.mipLevels - level)))
+                return false;
+            for (size_t l = level; l < srcMeta.mipLevels; l++) {
+                Image const *src = image.GetImage(l, 0, 0);
+                Image const *dst = result.GetImage(l - level, 0, 0);
+                memcpy(dst->pixels, src->pixels, min(src->slicePitch, dst->slicePitch));
+            }
+            image = std::move(result);
+            return true;
+        }
+    }
+    if (!DownscaleTexture(image, maxSize))
+        return false;
+    if (srcMeta.mipLevels > 1) {
+        ScratchImage mips;
+        if (FAILED(GenerateMipMaps(*image.GetImage(0, 0, 0), TEX_FILTER_BOX, 0, mips)))
+            return false;
+        image = std::move(mips);
+    }
+    if (image.GetMetadata().format != srcMeta.format) {
+        ScratchImage converted;
+        HRESULT hr = IsCompressed(srcMeta.format) ?
+            Compress(image.GetImages(), image.GetImageCount(), image.GetMetadata(), srcMeta.format, TEX_COMPRESS_PARALLEL, TEX_THRESHOLD_DEFAULT, converted) :
+            Convert(image.GetImages(), image.GetImageCount(), image.GetMetadata(), srcMeta.format, TEX_FILTER_DEFAULT, TEX_THRESHOLD_DEFAULT, converted);
+        if (FAILED(hr))
+            return false;
+        image = std::move(converted);
+    }
+    return true;
+}
+
+static bool HasFullMipChain(TexMetadata const &meta) {
+    size_t levels = 1;
+    for (size_t size = max(meta.width, meta.height); size > 1; size /= 2)
+        levels++;
+    return meta.mipLevels > 1 && meta.mipLevels == levels;
+}
+
+// each existing level is decoded and re-encoded on its own, no level is resampled
+static bool TranscodeLevels(ScratchImage &image, DXGI_FORMAT format) {
+    auto const &meta = image.GetMetadata();
+    bool hdr = format == DXGI_FORMAT_BC6H_UF16 || meta.format == DXGI_FORMAT_BC6H_UF16;
+    DXGI_FORMAT intermediate = hdr ? DXGI_FORMAT_R32G32B32A32_FLOAT : DXGI_FORMAT_R8G8B8A8_UNORM;
+    ScratchImage decoded, encoded;
+    HRESULT hr = IsCompressed(meta.format) ?
+        Decompress(image.GetImages(), image.GetImageCount(), meta, intermediate, decoded) :
+        Convert(image.GetImages(), image.GetImageCount(), meta, intermediate, TEX_FILTER_DEFAULT, TEX_THRESHOLD_DEFAULT, decoded);
+    if (FAILED(hr))
+        return false;
+    hr = IsCompressed(format) ?
+        Compress(decoded.GetImages(), decoded.GetImageCount(), decoded.GetMetadata(), format, TEX_COMPRESS_PARALLEL, TEX_THRESHOLD_DEFAULT, encoded) :
+        Convert(decoded.GetImages(), decoded.GetImageCount(), decoded.GetMetadata(), format, TEX_FILTER_DEFAULT, TEX_THRESHOLD_DEFAULT, encoded);
+    if (FAILED(hr))
+        return false;
+    image = std::move(encoded);
+    return true;
+}
+
+static path PrepareTexture(path const &inTexture, TexturePrepSettings const &settings, path const &tempFolder,
+    vector<TextureFormatDecision> *decisions)
+{
+    wstring ext = ToLower(inTexture.extension().wstring());
+    // QOI is not understood by ImportTexturesToRX3 and is always converted
+    bool qoi = ext == L".qoi";
+    if (!qoi && !settings.IsActive())
+        return inTexture;
+    string name = ToLower(ToUTF8(inTexture.stem().c_str()));
+    uint32_t maxSize = settings.MaxSizeFor(name);
+    TexMetadata meta;
+    if (!ReadTextureMetadata(inTexture, meta))
+        return inTexture;
+    bool resize = maxSize != 0 && (meta.width > maxSize || meta.height > maxSize);
+    if (meta.arraySize != 1 || meta.depth != 1 || meta.IsCubemap()) {
+        if (resize) {
+            ErrorMessage(ToUTF8(inTexture.c_str()) + ": cubemap, array and volume textures are not downscaled, imported at " +
+                to_string(meta.width) + "x" + to_string(meta.height));
+        }
+        return inTexture;
+    }
+    DXGI_FORMAT targetFormat = ext == L".dds" ? TextureFormatNameToDXGI(settings.FormatFor(name)) : DXGI_FORMAT_UNKNOWN;
+    bool transcode = targetFormat != DXGI_FORMAT_UNKNOWN && targetFormat != meta.format && HasFullMipChain(meta);
+    // block-compressed DDS and HDR sources already define their format
+    bool autoFormat = settings.autoFormat && ext != L".hdr" && !IsCompressed(meta.format) &&
+        FindTexturePattern(name, settings.formatPatterns).empty();
+    if (!resize && !autoFormat && !transcode && !qoi)
+        return inTexture;
+    ScratchImage image;
+    if (!LoadTextureFile(inTexture, image))
+        return inTexture;
+    path outPath;
+    bool saved = false;
+    if (autoFormat) {
+        TextureFormatDecision decision;
+        decision.name = inTexture.stem().wstring();
+        outPath = tempFolder / (inTexture.stem().wstring() + L".dds");
+        saved = (!resize || DownscaleTexture(image, maxSize)) && EncodeAutoFormat(image, outPath, decision);
+        if (saved && decisions)
+            decisions->push_back(decision);
+    }
+    else if (ext == L".dds") {
+        outPath = tempFolder / (inTexture.stem().wstring() + L".dds");
+        saved = (!resize || DownscaleDDS(image, maxSize)) && (!transcode || TranscodeLevels(image, targetFormat)) &&
+            SUCCEEDED(SaveToDDSFile(image.GetImages(), image.GetImageCount(), image.GetMetadata(), DDS_FLAGS_NONE, outPath.c_str()));
+    }
+    else if (DownscaleTexture(image, maxSize)) {
+        // plain images are handed over as uncompressed TGA, HDR stays HDR
+        if (ext == L".hdr") {
+            outPath = tempFolder / (inTexture.stem().wstring() + L".hdr");
+            saved = SUCCEEDED(SaveToHDRFile(*image.GetImage(0, 0, 0), outPath.c_str()));
+        }
+        else {
+            outPath = tempFolder / (inTexture.stem().wstring() + L".tga");
+            saved = SUCCEEDED(SaveToTGAFile(*image.GetImage(0, 0, 0), TGA_FLAGS_NONE, outPath.c_str()));
+        }
+    }
+    return saved ? outPath : inTexture;
+}
+
+vector<path> PrepareTexturesForImport(vector<path> const &inTextures, TexturePrepSettings const &settings, path const &tempFolder,
+    vector<TextureFormatDecision> *decisions)
+{
+    vector<path> result;
+    result.reserve(inTextures.size());
+    for (auto const &tex : inTextures)
+        result.push_back(PrepareTexture(tex, settings, tempFolder, decisions));
+    return result;
+}
+
+// The -writeTexMetadata table (<rx3>_metadata.csv, one row per texture, name first) with the class and format
+// appended to the rows of auto-formatted textures. Rows come from the imported metadata table if there is one.
+bool WriteTextureFormatDecisions(vector<TextureFormatDecision> const &decisions, path const &metadataFile, path const &tablePath) {
+    vector<pair<wstring, wstring>> rows;
+    map<wstring, size_t> rowIndex;
+    if (!metadataFile.empty() && exists(metadataFile)) {
+        TextFileTable table;
+        table.ReadUnicodeText(metadataFile);
+        for (auto const &r : table.Rows()) {
+            if (r.empty() || r[0].empty())
+                continue;
+            wstring rest;
+            for (size_t i = 1; i < r.size(); i++)
+                rest += L"," + r[i];
+            rowIndex.try_emplace(ToLower(r[0]), rows.size());
+            rows.emplace_back(r[0], rest);
+        }
+    }
+    for (auto const &d : decisions) {
+        wstring fields = L"," + AtoW(d.textureClass) + L"," + AtoW(d.format);
+        auto it = rowIndex.find(ToLower(d.name));
+        if (it != rowIndex.end())
+            rows[it->second].second += fields;
+        else
+            rows.emplace_back(d.name, fields);
+    }
+    // UTF-16 with BOM, like the tables rx3lib writes
+    std::ofstream file(tablePath, std::ios::binary);
+    if (!file.is_open())
+        return false;
+    file.write("\xFF\xFE", 2);
+    for (auto const &[name, rest] : rows) {
+        std::u16string line(name.begin(), name.end());
+        line.append(rest.begin(), rest.end());
+        line += u"\r\n";
+        file.write(reinterpret_cast<char const *>(line.data()), line.size() * sizeof(char16_t));
+    }
+    return file.good();
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "Rx3Utils.h"
+#include <cstdint>
+
+// Source texture preparation before ImportTexturesToRX3. Textures that need changes are written
+// to a temporary folder under their original name, all others keep their source path.
+struct TexturePrepSettings {
+    uint32_t maxSize = 0;
+    vector<pair<string, uint32_t>> maxSizeRules;
+    // DDS sources with a full mip chain are transcoded level by level to the texFormatFile format
+    vector<pair<string, string>> formatRules;
+    // textures not matched by any texFormatFile pattern are classified and encoded to the cheapest fitting format
+    bool autoFormat = false;
+    vector<string> formatPatterns;
+
+    void ReadRules(path const &texFormatFile);
+    uint32_t MaxSizeFor(string const &textureName) const;
+    string FormatFor(string const &textureName) const;
+    bool IsActive() const;
+};
+
+struct TextureFormatDecision {
+    wstring name;
+    string textureClass;
+    string format;
+};
+
+vector<path> PrepareTexturesForImport(vector<path> const &inTextures, TexturePrepSettings const &settings, path const &tempFolder,
+    vector<TextureFormatDecision> *decisions = nullptr);
+bool WriteTextureFormatDecisions(vector<TextureFormatDecision> const &decisions, path const &metadataFile, path const &tablePath);
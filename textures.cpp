@@ -0,0 +1,413 @@
+#include "textures.h"
+#include "hash.h"
+#include "Rx3Textures.h"
+#include "qoi.h"
+#include <emmintrin.h>
+#include <fstream>
+
+using namespace rx3utils;
+using namespace DirectX;
+
+static bool LoadQOIFile(path const &filePath, ScratchImage &image) {
+    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return false;
+    vector<uint8_t> data(size_t(file.tellg()));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char *>(data.data()), data.size()))
+        return false;
+    uint32_t width, height;
+    if (!ReadQOIHeader(data.data(), data.size(), width, height) ||
+        FAILED(image.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, width, height, 1, 1)))
+    {
+        return false;
+    }
+    Image const &img = *image.GetImage(0, 0, 0);
+    return DecodeQOI(data.data(), data.size(), img.pixels, width, height, img.rowPitch);
+}
+
+static bool SaveQOIFile(Image const &image, path const &filePath) {
+    ScratchImage converted;
+    Image const *src = &image;
+    if (image.format != DXGI_FORMAT_R8G8B8A8_UNORM) {
+        HRESULT hr = IsCompressed(image.format) ? Decompress(image, DXGI_FORMAT_R8G8B8A8_UNORM, converted) :
+            Convert(image, DXGI_FORMAT_R8G8B8A8_UNORM, TEX_FILTER_DEFAULT, TEX_THRESHOLD_DEFAULT, converted);
+        if (FAILED(hr))
+            return false;
+        src = converted.GetImage(0, 0, 0);
+    }
+    vector<uint8_t> data;
+    if (!EncodeQOI(src->pixels, uint32_t(src->width), uint32_t(src->height), src->rowPitch, data))
+        return false;
+    std::ofstream file(filePath, std::ios::binary);
+    if (!file.is_open())
+        return false;
+    file.write(reinterpret_cast<char const *>(data.data()), data.size());
+    return file.good();
+}
+
+bool LoadTextureFile(path const &filePath, ScratchImage &image) {
+    wstring ext = ToLower(filePath.extension().wstring());
+    HRESULT hr;
+    if (ext == L".qoi")
+        return LoadQOIFile(filePath, image);
+    if (ext == L".dds")
+        hr = LoadFromDDSFile(filePath.c_str(), DDS_FLAGS_NONE, nullptr, image);
+    else if (ext == L".hdr")
+        hr = LoadFromHDRFile(filePath.c_str(), nullptr, image);
+    else if (ext == L".tga")
+        hr = LoadFromTGAFile(filePath.c_str(), TGA_FLAGS_NONE, nullptr, image);
+    else
+        hr = LoadFromWICFile(filePath.c_str(), WIC_FLAGS_NONE, nullptr, image);
+    return SUCCEEDED(hr);
+}
+
+// 2x2 box filter for 8-bit RGBA (UNORM or sRGB, averaged as stored), both dimensions even
+bool HalveTexture(Image const &src, ScratchImage &dst) {
+    if ((src.format != DXGI_FORMAT_R8G8B8A8_UNORM && src.format != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB) || src.width < 2 || src.height < 2 || (src.width % 2) || (src.height % 2))
+        return false;
+    size_t w = src.width / 2, h = src.height / 2;
+    if (FAILED(dst.Initialize2D(src.format, w, h, 1, 1)))
+        return false;
+    Image const &out = *dst.GetImage(0, 0, 0);
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const round = _mm_set1_epi16(2);
+    for (size_t y = 0; y < h; y++) {
+        uint8_t const *row0 = src.pixels + (y * 2) * src.rowPitch;
+        uint8_t const *row1 = row0 + src.rowPitch;
+        uint8_t *dstRow = out.pixels + y * out.rowPitch;
+        size_t x = 0;
+        for (; x + 2 <= w; x += 2) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<__m128i const *>(row0 + x * 8));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<__m128i const *>(row1 + x * 8));
+            __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+            __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+            lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+            hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+            __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), round), 2);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(dstRow + x * 4), _mm_packus_epi16(sum, sum));
+        }
+        for (; x < w; x++) {
+            for (size_t c = 0; c < 4; c++) {
+                dstRow[x * 4 + c] = uint8_t((row0[x * 8 + c] + row0[x * 8 + 4 + c] +
+                    row1[x * 8 + c] + row1[x * 8 + 4 + c] + 2) / 4);
+            }
+        }
+    }
+    return true;
+}
+
+// Reduces the top level so that neither side exceeds maxSize; repeated SIMD halving for 8-bit RGBA,
+// a final DirectXTex box resize for float data, odd sizes and non power-of-two ratios
+bool DownscaleTexture(ScratchImage &image, uint32_t maxSize) {
+    auto const &meta = image.GetMetadata();
+    if (maxSize == 0 || (meta.width <= maxSize && meta.height <= maxSize))
+        return true;
+    ScratchImage current;
+    Image const &top = *image.GetImage(0, 0, 0);
+    if (top.format != DXGI_FORMAT_R8G8B8A8_UNORM && top.format != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB && top.format != DXGI_FORMAT_R32G32B32A32_FLOAT) {
+        DXGI_FORMAT target = (top.format == DXGI_FORMAT_BC6H_UF16 || top.format == DXGI_FORMAT_R16G16B16A16_FLOAT) ?
+            DXGI_FORMAT_R32G32B32A32_FLOAT : DXGI_FORMAT_R8G8B8A8_UNORM;
+        // sRGB sources stay sRGB, the caller converts back to the source format
+        if (IsSRGB(top.format))
+            target = MakeSRGB(target);
+        HRESULT hr = IsCompressed(top.format) ? Decompress(top, target, current) :
+            Convert(top, target, TEX_FILTER_DEFAULT, TEX_THRESHOLD_DEFAULT, current);
+        if (FAILED(hr))
+            return false;
+    }
+    else if (FAILED(current.InitializeFromImage(top)))
+        return false;
+    while (true) {
+        Image const &img = *current.GetImage(0, 0, 0);
+        if ((max(img.width, img.height) / 2) < maxSize)
+            break;
+        ScratchImage half;
+        if (!HalveTexture(img, half))
+            break;
+        current = std::move(half);
+    }
+    Image const &img = *current.GetImage(0, 0, 0);
+    if (img.width > maxSize || img.height > maxSize) {
+        double scale = double(maxSize) / double(max(img.width, img.height));
+        size_t w = max<size_t>(size_t(img.width * scale + 0.5), 1);
+        size_t h = max<size_t>(size_t(img.height * scale + 0.5), 1);
+        ScratchImage resized;
+        if (FAILED(Resize(img, w, h, TEX_FILTER_BOX, resized)))
+            return false;
+        current = std::move(resized);
+    }
+    image = std::move(current);
+    return true;
+}
+
+uint64_t HashTexturePixels(ScratchImage const &image) {
+    auto const &meta = image.GetMetadata();
+    Hasher64 hasher;
+    hasher.UpdateValue(uint64_t(meta.width));
+    hasher.UpdateValue(uint64_t(meta.height));
+    hasher.UpdateValue(uint64_t(meta.depth));
+    hasher.UpdateValue(uint64_t(meta.arraySize));
+    hasher.UpdateValue(uint64_t(meta.mipLevels));
+    hasher.UpdateValue(uint32_t(meta.format));
+    hasher.UpdateValue(uint32_t(meta.dimension));
+    hasher.Update(image.GetPixels(), image.GetPixelsSize());
+    return hasher.Digest();
+}
+
+bool MatchesWildcard(string const &name, string const &pattern) {
+    size_t n = 0, p = 0, starP = string::npos, starN = 0;
+    while (n < name.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || tolower(pattern[p]) == tolower(name[n]))) {
+            n++;
+            p++;
+        }
+        else if (p < pattern.size() && pattern[p] == '*') {
+            starP = p++;
+            starN = n;
+        }
+        else if (starP != string::npos) {
+            p = starP + 1;
+            n = ++starN;
+        }
+        else
+            return false;
+    }
+    while (p < pattern.size() && pattern[p] == '*')
+        p++;
+    return p == pattern.size();
+}
+
+string FindTexturePattern(string const &textureName, vector<string> const &patterns) {
+    for (auto const &pattern : patterns) {
+        if (MatchesWildcard(textureName, pattern))
+            return pattern;
+    }
+    return string();
+}
+
+DXGI_FORMAT Rx3TextureFormatToDXGI(uint8_t format) {
+    switch (format) {
+    case 0: return DXGI_FORMAT_BC1_UNORM;
+    case 1: return DXGI_FORMAT_BC2_UNORM;
+    case 2: return DXGI_FORMAT_BC3_UNORM;
+    case 3: return DXGI_FORMAT_B8G8R8A8_UNORM;
+    case 4: return DXGI_FORMAT_R8_UNORM;
+    case 12: return DXGI_FORMAT_BC4_UNORM;
+    case 13: return DXGI_FORMAT_BC5_UNORM;
+    case 14: return DXGI_FORMAT_BC6H_UF16;
+    case 15: return DXGI_FORMAT_BC7_UNORM;
+    }
+    return DXGI_FORMAT_UNKNOWN;
+}
+
+string Rx3TextureFormatName(uint8_t format) {
+    switch (format) {
+    case 0: return "dxt1";
+    case 1: return "dxt3";
+    case 2: return "dxt5";
+    case 3: return "argb8888";
+    case 4: return "l8";
+    case 12: return "ati1";
+    case 13: return "ati2";
+    case 14: return "bc6h";
+    case 15: return "bc7";
+    }
+    return "format" + to_string(format);
+}
+
+string NormalizeTextureFormatName(string const &formatName) {
+    static map<string, string> const aliases = {
+        { "bc1", "dxt1" }, { "bc2", "dxt3" }, { "bc3", "dxt5" }, { "bc4", "ati1" }, { "bc5", "ati2" }
+    };
+    string name = ToLower(formatName);
+    auto it = aliases.find(name);
+    return it != aliases.end() ? it->second : name;
+}
+
+DXGI_FORMAT TextureFormatNameToDXGI(string const &formatName) {
+    static map<string, DXGI_FORMAT> const formats = {
+        { "dxt1", DXGI_FORMAT_BC1_UNORM }, { "bc1", DXGI_FORMAT_BC1_UNORM },
+        { "dxt3", DXGI_FORMAT_BC2_UNORM }, { "bc2", DXGI_FORMAT_BC2_UNORM },
+        { "dxt5", DXGI_FORMAT_BC3_UNORM }, { "bc3", DXGI_FORMAT_BC3_UNORM },
+        { "ati1", DXGI_FORMAT_BC4_UNORM }, { "bc4", DXGI_FORMAT_BC4_UNORM },
+        { "ati2", DXGI_FORMAT_BC5_UNORM }, { "bc5", DXGI_FORMAT_BC5_UNORM },
+        { "bc6h", DXGI_FORMAT_BC6H_UF16 }, { "bc7", DXGI_FORMAT_BC7_UNORM },
+        { "argb8888", DXGI_FORMAT_B8G8R8A8_UNORM }, { "rgba8888", DXGI_FORMAT_R8G8B8A8_UNORM },
+        { "l8", DXGI_FORMAT_R8_UNORM }
+    };
+    auto it = formats.find(ToLower(formatName));
+    return it != formats.end() ? it->second : DXGI_FORMAT_UNKNOWN;
+}
+
+bool ReadRx3TextureInfo(Rx3File const &rx3, Rx3FileChunk const &chunk, Rx3TextureInfo &info) {
+    if (chunk.size < 20)
+        return false;
+    uint8_t const *p = rx3.ChunkData(chunk);
+    info.type = p[4];
+    info.format = p[5];
+    info.flags = rx3.Read16(p + 6);
+    info.width = rx3.Read16(p + 8);
+    info.height = rx3.Read16(p + 10);
+    info.depth = rx3.Read16(p + 12);
+    info.faces = rx3.Read16(p + 14);
+    info.levels = p[16];
+    return info.width != 0 && info.height != 0 && info.levels != 0;
+}
+
+bool GetRx3TextureLevel(Rx3File const &rx3, Rx3FileChunk const &chunk, uint32_t face, uint32_t level, Rx3TextureLevel &out) {
+    Rx3TextureInfo info;
+    if (!ReadRx3TextureInfo(rx3, chunk, info))
+        return false;
+    if (face >= info.NumFaces() || level >= info.levels)
+        return false;
+    uint8_t const *p = rx3.ChunkData(chunk) + 20;
+    uint8_t const *end = rx3.ChunkData(chunk) + chunk.size;
+    uint32_t target = face * info.levels + level;
+    // records are walked by their stored sizes, so pixel data before the target level is never touched
+    for (uint32_t i = 0; i <= target; i++) {
+        if (p + 16 > end)
+            return false;
+        uint32_t size = rx3.Read32(p + 8);
+        if (p + 16 + size > end)
+            return false;
+        if (i == target) {
+            out.width = max<uint32_t>(info.width >> level, 1);
+            out.height = max<uint32_t>(info.height >> level, 1);
+            out.size = size;
+            out.data = p + 16;
+            return true;
+        }
+        p += 16 + size;
+    }
+    return false;
+}
+
+uint32_t SelectRx3TextureLevel(Rx3TextureInfo const &info, uint32_t maxSize) {
+    uint32_t level = 0;
+    if (maxSize != 0) {
+        while ((level + 1) < info.levels && max<uint32_t>(info.width >> level, info.height >> level) > maxSize)
+            level++;
+    }
+    return level;
+}
+
+bool CanDecodeRx3Texture(Rx3File const &rx3, Rx3FileChunk const &chunk) {
+    Rx3TextureInfo info;
+    // console textures are byte-swapped and tiled, these go through rx3lib
+    return !rx3.IsBigEndian() && ReadRx3TextureInfo(rx3, chunk, info) && Rx3TextureFormatToDXGI(info.format) != DXGI_FORMAT_UNKNOWN;
+}
+
+bool DecodeRx3Texture(Rx3File const &rx3, Rx3FileChunk const &chunk, uint32_t maxSize, DirectX::ScratchImage &image) {
+    using namespace DirectX;
+    Rx3TextureInfo info;
+    if (!CanDecodeRx3Texture(rx3, chunk) || !ReadRx3TextureInfo(rx3, chunk, info))
+        return false;
+    Rx3TextureLevel l;
+    if (!GetRx3TextureLevel(rx3, chunk, 0, SelectRx3TextureLevel(info, maxSize), l))
+        return false;
+    Image src = {};
+    src.width = l.width;
+    src.height = l.height;
+    src.format = Rx3TextureFormatToDXGI(info.format);
+    if (FAILED(ComputePitch(src.format, src.width, src.height, src.rowPitch, src.slicePitch)) || src.slicePitch > l.size)
+        return false;
+    src.pixels = const_cast<uint8_t *>(l.data);
+    HRESULT hr;
+    if (IsCompressed(src.format))
+        hr = Decompress(src, DXGI_FORMAT_R8G8B8A8_UNORM, image);
+    else if (src.format != DXGI_FORMAT_R8G8B8A8_UNORM)
+        hr = Convert(src, DXGI_FORMAT_R8G8B8A8_UNORM, TEX_FILTER_DEFAULT, TEX_THRESHOLD_DEFAULT, image);
+    else
+        hr = image.InitializeFromImage(src);
+    return SUCCEEDED(hr);
+}
+
+bool SaveTextureImage(DirectX::Image const &image, path const &filePath) {
+    using namespace DirectX;
+    wstring ext = ToLower(filePath.extension().wstring());
+    HRESULT hr;
+    if (ext == L".qoi")
+        return SaveQOIFile(image, filePath);
+    if (ext == L".dds")
+        hr = SaveToDDSFile(image, DDS_FLAGS_NONE, filePath.c_str());
+    else if (ext == L".tga")
+        hr = SaveToTGAFile(image, TGA_FLAGS_NONE, filePath.c_str());
+    else if (ext == L".hdr") {
+        ScratchImage hdr;
+        hr = Convert(image, DXGI_FORMAT_R32G32B32A32_FLOAT, TEX_FILTER_DEFAULT, TEX_THRESHOLD_DEFAULT, hdr);
+        if (SUCCEEDED(hr))
+            hr = SaveToHDRFile(*hdr.GetImage(0, 0, 0), filePath.c_str());
+    }
+    else if (ext == L".jpg" || ext == L".jpeg")
+        hr = SaveToWICFile(image, WIC_FLAGS_NONE, GetWICCodec(WIC_CODEC_JPEG), filePath.c_str());
+    else if (ext == L".bmp")
+        hr = SaveToWICFile(image, WIC_FLAGS_NONE, GetWICCodec(WIC_CODEC_BMP), filePath.c_str());
+    else
+        hr = SaveToWICFile(image, WIC_FLAGS_NONE, GetWICCodec(WIC_CODEC_PNG), filePath.c_str());
+    return SUCCEEDED(hr);
+}
+
+static bool CopyRx3TextureLevels(Rx3File const &rx3, Rx3FileChunk const &chunk, DirectX::ScratchImage &image) {
+    Rx3TextureInfo info;
+    if (!ReadRx3TextureInfo(rx3, chunk, info) ||
+        FAILED(image.Initialize2D(Rx3TextureFormatToDXGI(info.format), info.width, info.height, 1, info.levels)))
+    {
+        return false;
+    }
+    for (uint32_t level = 0; level < info.levels; level++) {
+        Rx3TextureLevel l;
+        DirectX::Image const *dst = image.GetImage(level, 0, 0);
+        if (!GetRx3TextureLevel(rx3, chunk, 0, level, l) || l.size < dst->slicePitch)
+            return false;
+        memcpy(dst->pixels, l.data, dst->slicePitch);
+    }
+    return true;
+}
+
+// Every texture is decoded once and written in each of the given formats ("" is PNG). With maxSize 0 the
+// top level is written, DDS output then takes the stored levels as they are. Cube maps, volumes and BC6H
+// are left to ExtractTexturesFromRX3.
+bool ExtractDecodedTexturesFromRX3(Rx3File const &rx3, path const &outDir, uint32_t maxSize, vector<string> const &formats) {
+    return ExtractDecodedTexturesFromRX3(rx3, rx3.FindChunks(RX3_CHUNK_TEXTURE), outDir, maxSize, formats);
+}
+
+bool ExtractDecodedTexturesFromRX3(Rx3File const &rx3, vector<Rx3FileChunk const *> const &textures, path const &outDir, uint32_t maxSize,
+    vector<string> const &formats)
+{
+    for (auto const *t : textures) {
+        Rx3TextureInfo info;
+        if (t->name.empty() || !CanDecodeRx3Texture(rx3, *t) || !ReadRx3TextureInfo(rx3, *t, info))
+            return false;
+        if (maxSize == 0 && (info.NumFaces() > 1 || info.depth > 1 || Rx3TextureFormatToDXGI(info.format) == DXGI_FORMAT_BC6H_UF16))
+            return false;
+    }
+    vector<wstring> extensions;
+    bool needsDecode = false;
+    for (auto const &f : formats) {
+        extensions.push_back(f.empty() ? L".png" : (L"." + AtoW(f)));
+        if (maxSize != 0 || extensions.back() != L".dds")
+            needsDecode = true;
+    }
+    create_directories(outDir);
+    // any texture that fails to decode or save fails the whole file, callers then export it through rx3lib (or, for previews, skip it)
+    for (auto const *t : textures) {
+        DirectX::ScratchImage image;
+        if (needsDecode && !DecodeRx3Texture(rx3, *t, maxSize, image))
+            return false;
+        for (auto const &ext : extensions) {
+            path outPath = outDir / (AtoW(t->name) + ext);
+            if (maxSize == 0 && ext == L".dds") {
+                DirectX::ScratchImage levels;
+                if (!CopyRx3TextureLevels(rx3, *t, levels) || FAILED(DirectX::SaveToDDSFile(levels.GetImages(), levels.GetImageCount(),
+                    levels.GetMetadata(), DirectX::DDS_FLAGS_NONE, outPath.c_str())))
+                {
+                    return false;
+                }
+            }
+            else if (!SaveTextureImage(*image.GetImage(0, 0, 0), outPath))
+                return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "Rx3Utils.h"
+#include "DirectXTex.h"
+#include "rx3file.h"
+#include <cstdint>
+
+// TEXTURE chunk header; followed by one { pitch, lines, size, padding } record and pixel data
+// per face and mip level, faces outermost
+struct Rx3TextureInfo {
+    uint8_t type = 0;
+    uint8_t format = 0;
+    uint16_t flags = 0;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    uint16_t depth = 0;
+    uint16_t faces = 0;
+    uint8_t levels = 0;
+    // 0 is stored for plain 2D textures as well as 1
+    uint32_t NumFaces() const { return faces == 0 ? 1 : faces; }
+};
+
+struct Rx3TextureLevel {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t size = 0;
+    uint8_t const *data = nullptr;
+};
+
+bool LoadTextureFile(path const &filePath, DirectX::ScratchImage &image);
+bool HalveTexture(DirectX::Image const &src, DirectX::ScratchImage &dst);
+bool DownscaleTexture(DirectX::ScratchImage &image, uint32_t maxSize);
+uint64_t HashTexturePixels(DirectX::ScratchImage const &image);
+bool MatchesWildcard(string const &name, string const &pattern);
+string FindTexturePattern(string const &textureName, vector<string> const &patterns);
+DXGI_FORMAT Rx3TextureFormatToDXGI(uint8_t format);
+DXGI_FORMAT TextureFormatNameToDXGI(string const &formatName);
+string Rx3TextureFormatName(uint8_t format);
+// lower-cased, BCn aliases replaced with the names Rx3TextureFormatName uses
+string NormalizeTextureFormatName(string const &formatName);
+bool ReadRx3TextureInfo(Rx3File const &rx3, Rx3FileChunk const &chunk, Rx3TextureInfo &info);
+bool GetRx3TextureLevel(Rx3File const &rx3, Rx3FileChunk const &chunk, uint32_t face, uint32_t level, Rx3TextureLevel &out);
+uint32_t SelectRx3TextureLevel(Rx3TextureInfo const &info, uint32_t maxSize);
+bool CanDecodeRx3Texture(Rx3File const &rx3, Rx3FileChunk const &chunk);
+bool DecodeRx3Texture(Rx3File const &rx3, Rx3FileChunk const &chunk, uint32_t maxSize, DirectX::ScratchImage &image);
+bool SaveTextureImage(DirectX::Image const &image, path const &filePath);
+bool ExtractDecodedTexturesFromRX3(Rx3File const &rx3, path const &outDir, uint32_t maxSize, vector<string> const &formats);
+bool ExtractDecodedTexturesFromRX3(Rx3File const &rx3, vector<Rx3FileChunk const *> const &textures, path const &outDir, uint32_t maxSize,
+    vector<string> const &formats);
@@ -0,0 +1,193 @@
+#include "verify.h"
+#include "rx3file.h"
+#include "textures.h"
+#include "vertexdecl.h"
+
+using namespace rx3utils;
+
+static string ChunkLabel(Rx3FileChunk const &chunk, size_t index) {
+    string label = Rx3ChunkTypeName(chunk.type) + " #" + to_string(index);
+    if (!chunk.name.empty())
+        label += " (" + chunk.name + ")";
+    return label;
+}
+
+static void VerifyTexture(Rx3File const &rx3, Rx3FileChunk const &chunk, string const &label, vector<string> &errors) {
+    Rx3TextureInfo info;
+    if (!ReadRx3TextureInfo(rx3, chunk, info)) {
+        errors.push_back(label + ": truncated header");
+        return;
+    }
+    DXGI_FORMAT format = Rx3TextureFormatToDXGI(info.format);
+    if (format == DXGI_FORMAT_UNKNOWN)
+        errors.push_back(label + ": unknown format " + to_string(info.format));
+    if (info.width == 0 || info.height == 0 || info.levels == 0) {
+        errors.push_back(label + ": empty dimensions");
+        return;
+    }
+    uint8_t const *data = rx3.ChunkData(chunk);
+    size_t pos = 20;
+    for (uint32_t face = 0; face < info.NumFaces(); face++) {
+        for (uint32_t level = 0; level < info.levels; level++) {
+            string where = label + " face " + to_string(face) + " level " + to_string(level);
+            if (pos + 16 > chunk.size) {
+                errors.push_back(where + ": level header out of bounds");
+                return;
+            }
+            uint32_t size = rx3.Read32(data + pos + 8);
+            pos += 16;
+            if (pos + uint64_t(size) > chunk.size) {
+                errors.push_back(where + ": data out of bounds");
+                return;
+            }
+            size_t rowPitch = 0, slicePitch = 0;
+            if (format != DXGI_FORMAT_UNKNOWN &&
+                SUCCEEDED(DirectX::ComputePitch(format, max(1u, uint32_t(info.width) >> level), max(1u, uint32_t(info.height) >> level), rowPitch, slicePitch)) &&
+                size < uint64_t(slicePitch) * max(1u, uint32_t(info.depth) >> level))
+            {
+                errors.push_back(where + ": " + to_string(size) + " bytes, expected " + to_string(slicePitch));
+            }
+            pos += size;
+        }
+    }
+}
+
+vector<string> VerifyRx3(path const &filePath) {
+    vector<string> errors;
+    Rx3File rx3;
+    if (!rx3.Open(filePath)) {
+        errors.push_back("invalid header or chunk out of bounds");
+        return errors;
+    }
+    uint8_t const *fileData = rx3.Data();
+    if (rx3.Read32(fileData + 8) != rx3.Size())
+        errors.push_back("header file size " + to_string(rx3.Read32(fileData + 8)) + " differs from actual size " + to_string(rx3.Size()));
+    auto const &chunks = rx3.Chunks();
+    // chunks must not overlap each other or the chunk table
+    vector<pair<uint64_t, size_t>> ranges;
+    for (size_t i = 0; i < chunks.size(); i++)
+        ranges.emplace_back(chunks[i].offset, i);
+    std::sort(ranges.begin(), ranges.end());
+    uint64_t tableEnd = 16 + uint64_t(chunks.size()) * 16;
+    uint64_t previousEnd = tableEnd;
+    for (auto const &[offset, i] : ranges) {
+        if (chunks[i].size == 0)
+            continue;
+        if (offset < previousEnd)
+            errors.push_back(ChunkLabel(chunks[i], i) + ": overlaps " + (previousEnd == tableEnd ? string("the chunk table") : string("the previous chunk")));
+        previousEnd = max(previousEnd, offset + chunks[i].size);
+    }
+
+    map<uint32_t, size_t> typeIndices;
+    vector<uint32_t> vertexCounts;
+    vector<Rx3FileChunk const *> vertexBuffers, indexBuffers;
+    uint32_t numBones = 0;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        auto const &c = chunks[i];
+        string label = ChunkLabel(c, typeIndices[c.type]++);
+        uint8_t const *data = rx3.ChunkData(c);
+        switch (c.type) {
+        case RX3_CHUNK_NAMES:
+        case RX3_CHUNK_TEXTURE:
+        case RX3_CHUNK_VERTEX_BUFFER:
+        case RX3_CHUNK_INDEX_BUFFER:
+        case RX3_CHUNK_VERTEX_FORMAT:
+            // these start with their own total size
+            if (c.size < 16 || rx3.Read32(data) > c.size) {
+                errors.push_back(label + ": section size exceeds chunk size");
+                continue;
+            }
+            break;
+        }
+        if (c.type == RX3_CHUNK_NAMES) {
+            uint32_t numNames = rx3.Read32(data + 4);
+            size_t pos = 16;
+            for (uint32_t n = 0; n < numNames; n++) {
+                if (pos + 8 > c.size || pos + 8 + uint64_t(rx3.Read32(data + pos + 4)) > c.size) {
+                    errors.push_back(label + ": name " + to_string(n) + " out of bounds");
+                    break;
+                }
+                pos += 8 + rx3.Read32(data + pos + 4);
+            }
+        }
+        else if (c.type == RX3_CHUNK_TEXTURE_BATCH) {
+            size_t numTextures = rx3.FindChunks(RX3_CHUNK_TEXTURE).size();
+            if (c.size < 4 || rx3.Read32(data) != numTextures)
+                errors.push_back(label + ": texture count doesn't match " + to_string(numTextures) + " texture chunks");
+        }
+        else if (c.type == RX3_CHUNK_TEXTURE)
+            VerifyTexture(rx3, c, label, errors);
+        else if (c.type == RX3_CHUNK_VERTEX_BUFFER) {
+            uint32_t numVertices = rx3.Read32(data + 4);
+            uint32_t vertexSize = rx3.Read32(data + 8);
+            if (16 + uint64_t(numVertices) * vertexSize > c.size)
+                errors.push_back(label + ": " + to_string(numVertices) + " vertices of " + to_string(vertexSize) + " bytes exceed the chunk");
+            else
+                vertexBuffers.push_back(&c);
+        }
+        else if (c.type == RX3_CHUNK_INDEX_BUFFER) {
+            uint32_t numIndices = rx3.Read32(data + 4);
+            uint32_t indexSize = data[8];
+            if (indexSize != 2 && indexSize != 4)
+                errors.push_back(label + ": invalid index size " + to_string(indexSize));
+            else if (16 + uint64_t(numIndices) * indexSize > c.size)
+                errors.push_back(label + ": " + to_string(numIndices) + " indices exceed the chunk");
+            else
+                indexBuffers.push_back(&c);
+        }
+        else if (c.type == RX3_CHUNK_SKELETON && c.size >= 8)
+            numBones = rx3.Read32(data + 4);
+    }
+
+    // k-th index buffer and vertex declaration belong to the k-th vertex buffer
+    auto allVertexBuffers = rx3.FindChunks(RX3_CHUNK_VERTEX_BUFFER);
+    auto allIndexBuffers = rx3.FindChunks(RX3_CHUNK_INDEX_BUFFER);
+    auto vertexFormats = rx3.FindChunks(RX3_CHUNK_VERTEX_FORMAT);
+    for (size_t k = 0; k < allIndexBuffers.size() && k < allVertexBuffers.size(); k++) {
+        auto const *ib = allIndexBuffers[k];
+        if (find(indexBuffers.begin(), indexBuffers.end(), ib) == indexBuffers.end())
+            continue;
+        uint8_t const *data = rx3.ChunkData(*ib);
+        uint32_t numIndices = rx3.Read32(data + 4);
+        uint32_t indexSize = data[8];
+        uint32_t numVertices = rx3.Read32(rx3.ChunkData(*allVertexBuffers[k]) + 4);
+        uint32_t maxIndex = 0;
+        for (uint32_t n = 0; n < numIndices; n++) {
+            uint32_t index = indexSize == 2 ? rx3.Read16(data + 16 + n * 2) : rx3.Read32(data + 16 + n * 4);
+            // 0xFFFF / 0xFFFFFFFF restart strips
+            if (index != (indexSize == 2 ? 0xFFFFu : 0xFFFFFFFFu))
+                maxIndex = max(maxIndex, index);
+        }
+        if (numIndices != 0 && maxIndex >= numVertices)
+            errors.push_back(ChunkLabel(*ib, k) + ": index " + to_string(maxIndex) + " out of range for " + to_string(numVertices) + " vertices");
+    }
+    if (numBones != 0) {
+        for (size_t k = 0; k < allVertexBuffers.size() && k < vertexFormats.size(); k++) {
+            auto const *vb = allVertexBuffers[k];
+            if (find(vertexBuffers.begin(), vertexBuffers.end(), vb) == vertexBuffers.end())
+                continue;
+            vector<Rx3VertexElement> elements;
+            if (!ReadRx3VertexDeclaration(rx3, *vertexFormats[k], elements)) {
+                errors.push_back(ChunkLabel(*vertexFormats[k], k) + ": unreadable declaration");
+                continue;
+            }
+            uint8_t const *data = rx3.ChunkData(*vb);
+            uint32_t numVertices = rx3.Read32(data + 4);
+            uint32_t vertexSize = rx3.Read32(data + 8);
+            for (auto const &e : elements) {
+                // blend indices
+                if (!e.usage.starts_with('i') || (e.componentSize != 1 && e.componentSize != 2) || e.offset + e.Size() > vertexSize)
+                    continue;
+                uint32_t maxBone = 0;
+                for (uint32_t v = 0; v < numVertices; v++) {
+                    uint8_t const *p = data + 16 + size_t(v) * vertexSize + e.offset;
+                    for (uint32_t b = 0; b < e.count; b++)
+                        maxBone = max(maxBone, e.componentSize == 1 ? uint32_t(p[b]) : uint32_t(rx3.Read16(p + b * 2)));
+                }
+                if (numVertices != 0 && maxBone >= numBones)
+                    errors.push_back(ChunkLabel(*vb, k) + ": bone index " + to_string(maxBone) + " out of range for " + to_string(numBones) + " bones");
+            }
+        }
+    }
+    return errors;
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include "Rx3Utils.h"
+
+// Structural checks of an rx3 file without decoding any payload: header and chunk table, chunk bounds and
+// overlaps, section sizes, names, texture batch count, texture level sizes against dimensions and format,
+// vertex/index buffer sizes, index ranges against vertex counts and bone indices against the skeleton.
+// Returns the problems found, empty if the file is valid.
+vector<string> VerifyRx3(path const &filePath);
@@ -0,0 +1,51 @@
+#include "vertexdecl.h"
+#include <charconv>
+
+using namespace rx3utils;
+
+bool ReadRx3VertexDeclaration(Rx3File const &rx3, Rx3FileChunk const &chunk, vector<Rx3VertexElement> &elements) {
+    elements.clear();
+    if (chunk.size < 16)
+        return false;
+    char const *text = reinterpret_cast<char const *>(rx3.ChunkData(chunk) + 16);
+    size_t length = chunk.size - 16;
+    size_t pos = 0;
+    while (pos < length) {
+        while (pos < length && (text[pos] == ' ' || text[pos] == '\0'))
+            pos++;
+        size_t end = pos;
+        while (end < length && text[end] != ' ' && text[end] != '\0')
+            end++;
+        if (end == pos)
+            break;
+        string token(text + pos, end - pos);
+        pos = end;
+        size_t first = token.find(':'), second = token.find(':', first + 1), last = token.rfind(':');
+        if (first == string::npos || second == string::npos || last == first)
+            return false;
+        Rx3VertexElement element;
+        element.usage = token.substr(0, first);
+        if (std::from_chars(token.data() + first + 1, token.data() + second, element.offset, 16).ec != std::errc())
+            return false;
+        string type = token.substr(last + 1);
+        size_t t = 0;
+        uint32_t count = 0;
+        for (; t < type.size() && isdigit(uint8_t(type[t])); t++)
+            count = count * 10 + (type[t] - '0');
+        if (count != 0)
+            element.count = count;
+        element.type = type.substr(t);
+        if (element.type.find("32") != string::npos)
+            element.componentSize = 4;
+        else if (element.type.find("16") != string::npos)
+            element.componentSize = 2;
+        else if (element.type.find("10") != string::npos || element.type.find("11") != string::npos)
+            element.componentSize = 0;
+        else if (element.type.find('8') != string::npos)
+            element.componentSize = 1;
+        else
+            return false;
+        elements.push_back(element);
+    }
+    return !elements.empty();
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include "rx3file.h"
+
+// Element of a VERTEX_FORMAT chunk declaration. Tokens look like "p0:00:00:0001:3f32": usage and index,
+// hex offset, stream, ..., then component count and type. Packed types (10/11-bit) are one 32-bit word.
+struct Rx3VertexElement {
+    string usage;
+    uint32_t offset = 0;
+    uint32_t count = 1;
+    string type;
+    uint32_t componentSize = 0; // 0 for packed types
+
+    uint32_t Size() const { return componentSize ? count * componentSize : 4; }
+};
+
+bool ReadRx3VertexDeclaration(Rx3File const &rx3, Rx3FileChunk const &chunk, vector<Rx3VertexElement> &elements);